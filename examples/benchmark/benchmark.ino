@@ -0,0 +1,110 @@
+// CrashRollbackGuard benchmark: times every public guard API on device and
+// counts storage operations and stack usage. Each scenario runs in a fresh
+// task so the stack high-water mark belongs to that scenario alone.
+//
+// Output is one JSON document on Serial. Every scenario is compared against
+// benchmark_baselines.h; any regression flips "pass" to false.
+//
+// Uses its own namespace ("crgbench") through crg::Store, so it measures
+// whichever CRG_STORAGE_BACKEND is compiled in. It never switches partitions:
+// the rollback scenario points "prev" at a missing slot, so the decision path
+// runs up to the partition switch. The host runner switches for real.
+
+#include <Arduino.h>
+#include <CrashRollbackGuard.h>
+#include <cstring>
+
+#include "benchmark_baselines.h"
+#include "benchmark_scenarios.h"
+
+static constexpr uint32_t BENCH_STACK = 8192;
+static constexpr uint8_t BENCH_RUNS = 5;
+
+//==================== Runner ====================
+
+struct Sample {
+  uint32_t us;
+  crg::StoreStats ops;
+  uint32_t stackBytes;
+};
+
+static void (*g_op)() = nullptr;
+static Sample g_sample;
+static TaskHandle_t g_caller = nullptr;
+
+static void benchTask(void*) {
+  crg::resetStoreStats();
+  const uint32_t startUs = micros();
+  g_op();
+  g_sample.us = micros() - startUs;
+  g_sample.ops = crg::storeStats();
+  // ESP-IDF reports the high-water mark in bytes.
+  g_sample.stackBytes = BENCH_STACK - uxTaskGetStackHighWaterMark(nullptr);
+  xTaskNotifyGive(g_caller);
+  vTaskDelete(nullptr);
+}
+
+static Sample runOnce(const Scenario& sc) {
+  sc.setup();
+  g_op = sc.op;
+  g_caller = xTaskGetCurrentTaskHandle();
+  xTaskCreate(benchTask, "crgbench", BENCH_STACK, nullptr, uxTaskPriorityGet(nullptr), nullptr);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  return g_sample;
+}
+
+static const Baseline* findBaseline(const char* name) {
+  for (const Baseline& b : BASELINES) {
+    if (strcmp(b.name, name) == 0) return &b;
+  }
+  return nullptr;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial && millis() < 2000) {
+    delay(10);
+  }
+
+  bool pass = true;
+  Serial.printf("{\"suite\":\"CrashRollbackGuard\",\"storage\":\"%s\",\"results\":[",
+                CRG_STORAGE_BACKEND == CRG_STORAGE_FLASHLOG ? "flashlog" : "nvs");
+  for (size_t i = 0; i < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); ++i) {
+    const Scenario& sc = SCENARIOS[i];
+
+    Sample best = runOnce(sc);
+    for (uint8_t run = 1; run < BENCH_RUNS; ++run) {
+      const Sample s = runOnce(sc);
+      if (s.us < best.us) best.us = s.us;
+      if (s.stackBytes > best.stackBytes) best.stackBytes = s.stackBytes;
+    }
+
+    const Baseline* base = findBaseline(sc.name);
+    const bool ok = base &&
+                    best.us <= base->maxUs &&
+                    best.ops.reads <= base->reads &&
+                    best.ops.writes <= base->writes &&
+                    best.ops.commits <= base->commits &&
+                    best.stackBytes <= base->maxStackBytes;
+    pass = pass && ok;
+
+    Serial.printf("%s{\"name\":\"%s\",\"us\":%lu,\"opens\":%lu,\"reads\":%lu,\"writes\":%lu,"
+                  "\"commits\":%lu,\"stack_bytes\":%lu,\"status\":\"%s\"}",
+                  i ? "," : "",
+                  sc.name,
+                  static_cast<unsigned long>(best.us),
+                  static_cast<unsigned long>(best.ops.opens),
+                  static_cast<unsigned long>(best.ops.reads),
+                  static_cast<unsigned long>(best.ops.writes),
+                  static_cast<unsigned long>(best.ops.commits),
+                  static_cast<unsigned long>(best.stackBytes),
+                  base ? (ok ? "ok" : "regression") : "no_baseline");
+  }
+  Serial.printf("],\"pass\":%s}\n", pass ? "true" : "false");
+
+  wipe();
+}
+
+void loop() {
+  delay(1000);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+// Stored ceilings for benchmark.ino and host/benchmark_host.cpp. A scenario
+// regresses when it needs more storage operations, more time or more stack
+// than listed here.
+//
+// Operation counts are what the host run of the current guard needs; they do
+// not depend on the board, and the host build checks only these. The device
+// rollback scenario stops short of the partition switch and stays below its
+// row. Time and stack values are for an ESP32 @ 240 MHz with a healthy NVS
+// partition; after an intended change, paste the numbers from the JSON output
+// (plus some headroom for time and stack) back into this table.
+
+struct Baseline {
+  const char* name;
+  uint32_t    maxUs;
+  uint32_t    reads;
+  uint32_t    writes;
+  uint32_t    commits;
+  uint32_t    maxStackBytes;
+};
+
+static const Baseline BASELINES[] = {
+  //  name                           maxUs   reads writes commits stack
+  {"beginEarly.clean",                4000,  6,    0,     0,      2048},
+  {"beginEarly.suspicious",          40000,  6,    2,     1,      2048},
+  {"beginEarly.pending_action",      60000,  7,    3,     1,      2048},
+  {"beginEarly.corrupted_mirrors",    4000,  6,    0,     0,      2048},
+  {"beginEarly.rollback",            40000,  15,   8,     3,      2560},
+  {"decideEarly.suspicious",          4000,  6,    0,     0,      2048},
+  {"persistEarly",                   40000,  0,    2,     1,      2048},
+  {"markHealthyNow",                 60000,  5,    4,     1,      2048},
+  {"failCount",                       3000,  2,    0,     0,      1536},
+  {"getPreviousSlot",                 3000,  3,    0,     0,      1536},
+  {"saveCurrentAsPreviousSlot",      60000,  0,    4,     1,      2048},
+  {"armControlledRestart",           60000,  0,    4,     1,      2048},
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+// Scenario table shared by benchmark.ino (device) and host/benchmark_host.cpp
+// (host stand-ins). Include it from exactly one translation unit.
+
+#include <CrashRollbackGuard.h>
+#include <cstring>
+
+// Set by host/benchmark_host.cpp. On a board a real partition switch would
+// reboot mid-run, so there the rollback scenario points "prev" at a missing
+// slot and stops at SkippedNoPrev; the host stand-ins run it to esp_restart().
+#ifndef CRG_BENCH_HOST
+  #define CRG_BENCH_HOST 0
+#endif
+
+#if CRG_BENCH_HOST
+  #include "host_idf.h"
+#endif
+
+static constexpr const char* BENCH_NS = "crgbench";
+
+crg::CrashRollbackGuard guard;
+
+static bool g_suspicious = false;
+static bool benchResetPredicate(esp_reset_reason_t) { return g_suspicious; }
+
+//==================== Scenario setup helpers ====================
+
+static void wipe() {
+  guard.persistEarly(); // nothing staged by the previous scenario may leak into this one
+  crg::Store s;
+  s.begin(BENCH_NS, false);
+  s.clear();
+  s.end();
+}
+
+static void configure(uint32_t failLimit, bool suspicious) {
+  crg::Options opt;
+  opt.nvsNamespace = BENCH_NS;
+  opt.failLimit = failLimit;
+  opt.logLevel = crg::LogLevel::None;
+  guard.setOptions(opt);
+  guard.setSuspiciousResetPredicate(benchResetPredicate);
+  g_suspicious = suspicious;
+}
+
+static void writePrevLabel(const char* label) {
+  crg::Store s;
+  s.begin(BENCH_NS, false);
+  s.putString("prev", label);
+  s.putUInt("prevCrc", crg::integrity::crc32(label, strlen(label)));
+  s.end();
+}
+
+static void setupClean()      { wipe(); configure(5, false); }
+static void setupSuspicious() { wipe(); configure(5, true); }
+
+static void setupPending() {
+  setupSuspicious();
+  guard.armControlledRestart();
+}
+
+static void setupCorruptMirrors() {
+  setupClean();
+  crg::Store s;
+  s.begin(BENCH_NS, false);
+  s.putUInt("fails", 2);
+  s.putUInt("failsInv", 0); // should be ~2
+  s.end();
+}
+
+static void setupRollback() {
+  wipe();
+  configure(1, true);
+#if CRG_BENCH_HOST
+  crg::host::writeImage("ota_1", 1);
+  writePrevLabel("ota_1");
+#else
+  writePrevLabel("crg_no_such"); // not in the partition table -> SkippedNoPrev
+#endif
+}
+
+static void setupAfterCrash() {
+  setupSuspicious();
+  guard.beginEarly();
+}
+
+static void setupDecided() {
+  setupSuspicious();
+  guard.decideEarly();
+}
+
+static void setupWithPrev() {
+  setupClean();
+  guard.saveCurrentAsPreviousSlot();
+}
+
+//==================== Measured operations ====================
+
+static void opBeginEarly()      { guard.beginEarly(); }
+static void opDecideEarly()     { guard.decideEarly(); }
+static void opPersistEarly()    { guard.persistEarly(); }
+static void opMarkHealthy()     { guard.markHealthyNow(); }
+static void opFailCount()       { (void)guard.failCount(); }
+static void opGetPrevious()     { char label[CRG_LABEL_BUFFER_SIZE]; (void)guard.getPreviousSlot(label, sizeof(label)); }
+static void opSavePrevious()    { (void)guard.saveCurrentAsPreviousSlot(); }
+static void opArmRestart()      { guard.armControlledRestart(); }
+
+struct Scenario {
+  const char* name;
+  void (*setup)();
+  void (*op)();
+  bool restarts; // ends in esp_restart()
+};
+
+static const Scenario SCENARIOS[] = {
+  {"beginEarly.clean",             setupClean,          opBeginEarly,   false},
+  {"beginEarly.suspicious",        setupSuspicious,     opBeginEarly,   false},
+  {"beginEarly.pending_action",    setupPending,        opBeginEarly,   false},
+  {"beginEarly.corrupted_mirrors", setupCorruptMirrors, opBeginEarly,   false},
+  {"beginEarly.rollback",          setupRollback,       opBeginEarly,   CRG_BENCH_HOST != 0},
+  {"decideEarly.suspicious",       setupSuspicious,     opDecideEarly,  false},
+  {"persistEarly",                 setupDecided,        opPersistEarly, false},
+  {"markHealthyNow",               setupAfterCrash,     opMarkHealthy,  false},
+  {"failCount",                    setupAfterCrash,     opFailCount,    false},
+  {"getPreviousSlot",              setupWithPrev,       opGetPrevious,  false},
+  {"saveCurrentAsPreviousSlot",    setupClean,          opSavePrevious, false},
+  {"armControlledRestart",         setupClean,          opArmRestart,   false},
+};
@@ -0,0 +1,38 @@
+// Native ESP-IDF example: no Arduino core, logs go to esp_log (tag "CRG").
+// Settings come from `idf.py menuconfig` -> CrashRollbackGuard.
+
+#include <CrashRollbackGuard.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs_flash.h"
+
+static const char* TAG = "app";
+
+static crg::CrashRollbackGuard guard;
+
+extern "C" void app_main() {
+  esp_err_t err = nvs_flash_init();
+  if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+    ESP_ERROR_CHECK(nvs_flash_erase());
+    err = nvs_flash_init();
+  }
+  ESP_ERROR_CHECK(err);
+
+  crg::Options opt;
+  opt.autoSavePrevSlot = true;
+  guard.setOptions(opt);
+
+  // Decide now, flush the counters while the rest of the system starts.
+  const crg::Decision decision = guard.decideEarly();
+  guard.persistEarlyAsync();
+  ESP_LOGI(TAG, "decision=%d fails=%u", static_cast<int>(decision), (unsigned)guard.failCount());
+
+  // ... start Wi-Fi, MQTT, peripherals ...
+
+  for (;;) {
+    guard.loopTick(); // marks healthy after the stable window
+    vTaskDelay(pdMS_TO_TICKS(1000));
+  }
+}
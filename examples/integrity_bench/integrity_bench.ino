@@ -0,0 +1,93 @@
+// Micro-benchmark for the CRC-32 backends in CrgIntegrity.h.
+// Measures each backend on the record sizes the guard actually persists
+// (partition labels, component/signature/upStats/otaTx records) plus larger
+// image chunks, and checks that all backends agree.
+
+#include <Arduino.h>
+#include <CrashRollbackGuard.h>
+
+struct Backend {
+  const char* name;
+  uint32_t (*fn)(const void*, size_t, uint32_t);
+};
+
+static const Backend BACKENDS[] = {
+  {"bitwise", crg::integrity::crc32Bitwise},
+  {"table",   crg::integrity::crc32Table},
+  {"slice8",  crg::integrity::crc32Slice8},
+#if defined(ESP_PLATFORM)
+  {"rom",     crg::integrity::crc32Rom},
+#endif
+};
+
+// What the guard hashes: each record up to its crc field (components only
+// hash the counters), taken from the record types so the sizes cannot drift;
+// then a 256 B block and a 4 KiB image chunk.
+struct Size {
+  const char* what;
+  size_t size;
+};
+
+static const Size SIZES[] = {
+  {"label",     CRG_LABEL_BUFFER_SIZE - 1},
+#if CRG_FEATURE_COMPONENTS
+  {"component", sizeof(crg::detail::ComponentRecord::fails)},
+#endif
+#if CRG_FEATURE_CRASH_SIGNATURE
+  {"signature", offsetof(crg::detail::SignatureRecord, crc)},
+#endif
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  {"upStats",   offsetof(crg::detail::UptimeStatsRecord, crc)},
+#endif
+  {"otaTx",     offsetof(crg::detail::OtaTxRecord, crc)},
+  {"block",     256},
+  {"image",     4096},
+};
+
+constexpr uint32_t TARGET_BYTES = 256 * 1024; // work per measurement
+
+static uint8_t buffer[4096];
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial && millis() < 2000) {
+    delay(10);
+  }
+
+  for (size_t i = 0; i < sizeof(buffer); ++i) {
+    buffer[i] = static_cast<uint8_t>(esp_random());
+  }
+
+  Serial.println("record,size,backend,ns_per_call,mb_per_s,crc");
+  for (const Size& entry : SIZES) {
+    const size_t size = entry.size;
+    const uint32_t reference = crg::integrity::crc32Bitwise(buffer, size, 0);
+    const uint32_t iterations = TARGET_BYTES / size;
+
+    for (const Backend& backend : BACKENDS) {
+      volatile uint32_t sink = 0;
+      const uint32_t startUs = micros();
+      for (uint32_t i = 0; i < iterations; ++i) {
+        sink = backend.fn(buffer, size, 0);
+      }
+      const uint32_t elapsedUs = micros() - startUs;
+
+      const uint32_t crc = backend.fn(buffer, size, 0);
+      const float nsPerCall = (elapsedUs * 1000.0f) / iterations;
+      const float mbPerS = elapsedUs ? (static_cast<float>(size) * iterations) / elapsedUs : 0.0f;
+      Serial.printf("%s,%u,%s,%.1f,%.2f,%08lx%s\n",
+                    entry.what,
+                    static_cast<unsigned>(size),
+                    backend.name,
+                    nsPerCall,
+                    mbPerS,
+                    static_cast<unsigned long>(crc),
+                    crc == reference ? "" : " MISMATCH");
+      (void)sink;
+    }
+  }
+}
+
+void loop() {
+  delay(1000);
+}
@@ -96,14 +96,26 @@ void setup() {
 
   connectWiFi();
 
-  // BEFORE starting OTA write
-  guard.saveCurrentAsPreviousSlot();
+  // BEFORE starting OTA write: persist current + target slot as one NVS record.
+  // Update.end() below already switches the boot partition, so a reset before
+  // the commit must still leave the new image a prev slot to roll back to.
+  if (!guard.beginOtaTransaction()) {
+    Serial.println("[OTA] Could not store the OTA record, update skipped");
+    return;
+  }
+
+  if (!downloadAndUpdate()) {
+    guard.abortOtaTransaction();
+    return;
+  }
 
-  if (downloadAndUpdate()) {
-    guard.armControlledRestart();
+  // Verify the new image, add the restart intent to the record and switch the
+  // boot partition (again; Update.end() did it already).
+  if (guard.commitOtaTransaction()) {
     Serial.println("[OTA] Rebooting into new firmware");
     ESP.restart();
   }
+  Serial.println("[OTA] New image failed verification, staying on current firmware");
 }
 
 void loop() {
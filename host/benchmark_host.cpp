@@ -0,0 +1,72 @@
+// Host runner for the benchmark scenario table. Runs every scenario from
+// examples/benchmark on the host stand-ins and compares the storage operation
+// counts with the ceilings in benchmark_baselines.h. Time and stack ceilings
+// are for the device and are not checked here. The rollback scenario switches
+// to a real previous slot here and must end in esp_restart().
+//
+// Prints one JSON document like the sketch and exits 1 on any regression.
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "host_idf.h"
+
+#define CRG_BENCH_HOST 1
+
+#include "benchmark_baselines.h"
+#include "benchmark_scenarios.h"
+
+static const Baseline* findBaseline(const char* name) {
+  for (const Baseline& b : BASELINES) {
+    if (strcmp(b.name, name) == 0) return &b;
+  }
+  return nullptr;
+}
+
+int main() {
+  crg::host::reset();
+
+  bool pass = true;
+  std::printf("{\"suite\":\"CrashRollbackGuard\",\"target\":\"host\",\"storage\":\"%s\",\"results\":[",
+              CRG_STORAGE_BACKEND == CRG_STORAGE_FLASHLOG ? "flashlog" : "nvs");
+  for (size_t i = 0; i < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); ++i) {
+    const Scenario& sc = SCENARIOS[i];
+
+    sc.setup();
+    crg::resetStoreStats();
+    bool restarted = false;
+    try {
+      sc.op();
+    } catch (const crg::host::Restart&) {
+      restarted = true;
+    }
+    const crg::StoreStats ops = crg::storeStats();
+    if (restarted) {
+      // esp_restart() does not return: start over from a fresh guard and device.
+      guard.~CrashRollbackGuard();
+      new (&guard) crg::CrashRollbackGuard();
+      crg::host::reset();
+    }
+
+    const Baseline* base = findBaseline(sc.name);
+    const bool ok = base && restarted == sc.restarts &&
+                    ops.reads <= base->reads &&
+                    ops.writes <= base->writes &&
+                    ops.commits <= base->commits;
+    pass = pass && ok;
+
+    std::printf("%s{\"name\":\"%s\",\"opens\":%lu,\"reads\":%lu,\"writes\":%lu,\"commits\":%lu,\"status\":\"%s\"}",
+                i ? "," : "",
+                sc.name,
+                static_cast<unsigned long>(ops.opens),
+                static_cast<unsigned long>(ops.reads),
+                static_cast<unsigned long>(ops.writes),
+                static_cast<unsigned long>(ops.commits),
+                base ? (ok ? "ok" : "regression") : "no_baseline");
+  }
+  std::printf("],\"pass\":%s}\n", pass ? "true" : "false");
+
+  wipe();
+  return pass ? 0 : 1;
+}
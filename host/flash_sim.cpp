@@ -0,0 +1,70 @@
+#include "flash_sim.h"
+
+#include <cstring>
+
+namespace crg {
+namespace host {
+
+namespace {
+
+FlashSim g_sim;
+
+esp_err_t simRead(size_t offset, void* dst, size_t len) {
+  if (offset + len > FlashSim::SIZE) return ESP_ERR_INVALID_SIZE;
+  ++g_sim.reads;
+  std::memcpy(dst, g_sim.mem + offset, len);
+  return ESP_OK;
+}
+
+esp_err_t simWrite(size_t offset, const void* src, size_t len) {
+  if (offset + len > FlashSim::SIZE) return ESP_ERR_INVALID_SIZE;
+  ++g_sim.writes;
+  const uint8_t* bytes = static_cast<const uint8_t*>(src);
+  for (size_t i = 0; i < len; ++i) {
+    if (g_sim.cutAfterWrite == 0) {
+      g_sim.cutAfterWrite = -1;
+      throw PowerCut{};
+    }
+    if (g_sim.cutAfterWrite > 0) --g_sim.cutAfterWrite;
+    uint8_t& cell = g_sim.mem[offset + i];
+    if ((cell & bytes[i]) != bytes[i]) ++g_sim.overwrites;
+    cell &= bytes[i];
+  }
+  return ESP_OK;
+}
+
+esp_err_t simErase(size_t offset, size_t len) {
+  if (offset % flashlog::SECTOR_SIZE || len % flashlog::SECTOR_SIZE || offset + len > FlashSim::SIZE) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  for (size_t i = 0; i < len; ++i) {
+    if (g_sim.cutAfterErase == 0) {
+      g_sim.cutAfterErase = -1;
+      throw PowerCut{};
+    }
+    if (g_sim.cutAfterErase > 0) --g_sim.cutAfterErase;
+    g_sim.mem[offset + i] = 0xFF;
+  }
+  for (size_t s = offset / flashlog::SECTOR_SIZE; s < (offset + len) / flashlog::SECTOR_SIZE; ++s) {
+    ++g_sim.sectorErases[s];
+  }
+  return ESP_OK;
+}
+
+const flashlog::FlashIo kSimIo{simRead, simWrite, simErase};
+
+} // namespace
+
+FlashSim& installFlashSim() {
+  g_sim = FlashSim{};
+  std::memset(g_sim.mem, 0xFF, sizeof(g_sim.mem));
+  flashlog::setFlashIo(&kSimIo);
+  return g_sim;
+}
+
+FlashSim& flashSim() { return g_sim; }
+
+void remountFlash() { flashlog::setFlashIo(&kSimIo); }
+
+} // namespace host
+} // namespace crg
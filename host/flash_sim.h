@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CrgFlashLog.h"
+
+// RAM-backed NOR flash for crg::flashlog, plugged in through setFlashIo().
+// Programming can only clear bits, erase works on whole sectors, and a power
+// cut can be scheduled after any number of programmed or erased bytes.
+
+namespace crg {
+namespace host {
+
+// Thrown when a scheduled power cut hits. Catch it and call remountFlash().
+struct PowerCut {};
+
+struct FlashSim {
+  static constexpr size_t SIZE = 2 * flashlog::SECTOR_SIZE;
+
+  uint8_t  mem[SIZE];
+  uint32_t reads = 0;
+  uint32_t writes = 0;
+  uint32_t sectorErases[2] = {0, 0};
+  // Bytes that had to change 0 -> 1 without an erase; real flash would keep
+  // the 0 bits, so any non-zero value means the log wrote over live data.
+  uint32_t overwrites = 0;
+  // Power cut after this many more programmed / erased bytes (-1 = never).
+  long cutAfterWrite = -1;
+  long cutAfterErase = -1;
+};
+
+// Erased flash, counters cleared, simulator installed.
+FlashSim& installFlashSim();
+FlashSim& flashSim();
+// Reboot as the flash log sees it: the RAM image is dropped and rebuilt by mount().
+void remountFlash();
+
+} // namespace host
+} // namespace crg
@@ -0,0 +1,28 @@
+#pragma once
+
+// Minimal checks for the host tests: every failed CHECK prints its location,
+// main() returns host_test::result().
+
+#include <cstdio>
+
+namespace host_test {
+
+inline int& failures() {
+  static int count = 0;
+  return count;
+}
+
+inline int result() {
+  if (failures() == 0) std::printf("ok\n");
+  return failures() == 0 ? 0 : 1;
+}
+
+} // namespace host_test
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);     \
+      ++host_test::failures();                                                 \
+    }                                                                          \
+  } while (0)
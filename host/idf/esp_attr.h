@@ -0,0 +1,5 @@
+#pragma once
+
+// Host RAM survives host::reboot() the way RTC noinit memory survives a reset.
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+// Xtensa layout of the summary; host::crash() fills it like the panic handler would.
+#define APP_ELF_SHA256_SZ (CONFIG_APP_RETRIEVE_LEN_ELF_SHA + 1)
+
+typedef struct {
+  uint32_t bt[16];
+  uint32_t depth;
+  bool     corrupted;
+} esp_core_dump_bt_info_t;
+
+typedef struct {
+  uint32_t exc_cause;
+  uint32_t exc_vaddr;
+  uint32_t exc_a[16];
+  uint32_t epcx[7];
+  uint8_t  epcx_reg_bits;
+} esp_core_dump_summary_extra_info_t;
+
+typedef struct {
+  uint32_t                           exc_tcb;
+  char                               exc_task[16];
+  uint32_t                           exc_pc;
+  esp_core_dump_bt_info_t            exc_bt_info;
+  uint32_t                           core_dump_version;
+  uint8_t                            app_elf_sha256[APP_ELF_SHA256_SZ];
+  esp_core_dump_summary_extra_info_t ex_info;
+} esp_core_dump_summary_t;
+
+esp_err_t esp_core_dump_get_summary(esp_core_dump_summary_t* summary);
+esp_err_t esp_core_dump_image_get(size_t* out_addr, size_t* out_size);
+esp_err_t esp_core_dump_image_erase(void);
@@ -0,0 +1,18 @@
+#pragma once
+// Host stand-ins for the ESP-IDF headers the guard uses (host build only).
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                   0
+#define ESP_FAIL                 -1
+#define ESP_ERR_NO_MEM           0x101
+#define ESP_ERR_INVALID_ARG      0x102
+#define ESP_ERR_INVALID_STATE    0x103
+#define ESP_ERR_INVALID_SIZE     0x104
+#define ESP_ERR_NOT_FOUND        0x105
+#define ESP_ERR_INVALID_CRC      0x109
+#define ESP_ERR_NOT_SUPPORTED    0x106
+#define ESP_ERR_OTA_BASE         0x1500
+#define ESP_ERR_OTA_VALIDATE_FAILED (ESP_ERR_OTA_BASE + 0x03)
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+typedef enum {
+  ESP_OTA_IMG_NEW            = 0x0U,
+  ESP_OTA_IMG_PENDING_VERIFY = 0x1U,
+  ESP_OTA_IMG_VALID          = 0x2U,
+  ESP_OTA_IMG_INVALID        = 0x3U,
+  ESP_OTA_IMG_ABORTED        = 0x4U,
+  ESP_OTA_IMG_UNDEFINED      = 0xFFFFFFFFU,
+} esp_ota_img_states_t;
+
+typedef struct {
+  uint32_t magic_word;
+  uint32_t secure_version;
+  uint32_t reserv1[2];
+  char     version[32];
+  char     project_name[32];
+  char     time[16];
+  char     date[16];
+  char     idf_ver[32];
+  uint8_t  app_elf_sha256[32];
+  uint32_t reserv2[20];
+} esp_app_desc_t;
+
+const esp_partition_t* esp_ota_get_running_partition(void);
+const esp_partition_t* esp_ota_get_boot_partition(void);
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition);
+esp_err_t esp_ota_get_state_partition(const esp_partition_t* partition, esp_ota_img_states_t* ota_state);
+esp_err_t esp_ota_get_partition_description(const esp_partition_t* partition, esp_app_desc_t* app_desc);
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void);
+int esp_ota_get_app_elf_sha256(char* dst, size_t size);
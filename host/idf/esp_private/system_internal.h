@@ -0,0 +1,7 @@
+#pragma once
+
+#include "esp_system.h"
+
+// Hint left in RTC memory by esp_restart() and the panic handler; set with
+// host::earlyReset().
+esp_reset_reason_t esp_reset_reason_get_hint(void);
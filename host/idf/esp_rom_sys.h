@@ -0,0 +1,6 @@
+#pragma once
+
+#include "soc/reset_reasons.h"
+
+// Reason latched by the ROM; set with host::earlyReset().
+soc_reset_reason_t esp_rom_get_reset_reason(int cpu_no);
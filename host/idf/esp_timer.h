@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Microseconds on the host clock (host::advanceMs()).
+int64_t esp_timer_get_time(void);
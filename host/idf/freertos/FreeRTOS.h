@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef int          BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t     TickType_t;
+typedef uint8_t      StackType_t; // ESP-IDF counts stack in bytes
+
+typedef struct { int unused; } StaticTask_t;
+typedef struct { int count; } StaticSemaphore_t;
+typedef StaticSemaphore_t* SemaphoreHandle_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define tskNO_AFFINITY 0x7FFFFFFF
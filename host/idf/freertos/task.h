@@ -0,0 +1,14 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+#define taskSCHEDULER_SUSPENDED   0
+#define taskSCHEDULER_NOT_STARTED 1
+#define taskSCHEDULER_RUNNING     2
+
+// Runs the task function to completion before returning.
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                           void* arg, UBaseType_t priority, StackType_t* stack,
+                                           StaticTask_t* tcb, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+BaseType_t xTaskGetSchedulerState(void);
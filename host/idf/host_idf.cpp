@@ -0,0 +1,581 @@
+#include "host_idf.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "esp_core_dump.h"
+#include "esp_flash.h"
+#include "esp_log.h"
+#include "esp_private/system_internal.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include "CrashRollbackGuard.h"
+
+namespace {
+
+//==================== Partitions and images ====================
+
+constexpr uint32_t kSector = 4096;
+constexpr uint32_t kDumpAddr = 0x320000; // core dump image in main flash
+constexpr size_t kDumpSize = 256;
+
+enum PartIndex { P_FACTORY, P_OTA0, P_OTA1, P_NVS, P_CRGLOG, P_COUNT };
+
+const esp_partition_t kParts[P_COUNT] = {
+  {nullptr, ESP_PARTITION_TYPE_APP,  ESP_PARTITION_SUBTYPE_APP_FACTORY, 0x010000, 0x100000, kSector, "factory", false},
+  {nullptr, ESP_PARTITION_TYPE_APP,  ESP_PARTITION_SUBTYPE_APP_OTA_0,   0x110000, 0x100000, kSector, "ota_0",   false},
+  {nullptr, ESP_PARTITION_TYPE_APP,  ESP_PARTITION_SUBTYPE_APP_OTA_1,   0x210000, 0x100000, kSector, "ota_1",   false},
+  {nullptr, ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_NVS,    0x009000, 0x005000, kSector, "nvs",     false},
+  {nullptr, ESP_PARTITION_TYPE_DATA, static_cast<esp_partition_subtype_t>(0x40), 0x310000, 0x002000, kSector, "crglog", false},
+};
+
+struct Slot {
+  bool present = false;
+  uint32_t build = 0;
+  esp_ota_img_states_t state = ESP_OTA_IMG_UNDEFINED;
+};
+
+struct Device {
+  Slot slots[P_OTA1 + 1];
+  int running = P_OTA0;
+  int boot = P_OTA0;
+  bool rollback = true;
+  esp_reset_reason_t reason = ESP_RST_POWERON;
+  bool early = false; // esp_reset_reason() not initialized yet, see earlyReset()
+  soc_reset_reason_t romReason = RESET_REASON_CHIP_POWER_ON;
+  esp_reset_reason_t hint = ESP_RST_UNKNOWN;
+  int64_t nowUs = 0;
+  uint32_t restarts = 0;
+  bool dumpPresent = false;
+  uint32_t dumpSeq = 0;
+  esp_core_dump_summary_t dump{};
+  std::vector<uint8_t> dumpImage;
+  std::vector<uint8_t> data[P_COUNT];
+  std::map<std::string, std::map<std::string, std::pair<nvs_type_t, std::vector<uint8_t>>>> nvs;
+  struct Handle {
+    std::string ns;
+    bool readOnly;
+    bool open;
+  };
+  std::vector<Handle> handles;
+};
+
+// Function-local so the early boot hook can use the device before the
+// globals of this file are constructed.
+Device& device() {
+  static Device d;
+  return d;
+}
+
+bool g_initialized = false;
+
+Device& dev() {
+  if (!g_initialized) crg::host::reset();
+  return device();
+}
+
+int indexOf(const esp_partition_t* p) {
+  if (!p || p < kParts || p >= kParts + P_COUNT) return -1;
+  return static_cast<int>(p - kParts);
+}
+
+int indexOf(const char* label) {
+  for (int i = 0; i < P_COUNT; ++i) {
+    if (std::strcmp(kParts[i].label, label) == 0) return i;
+  }
+  std::fprintf(stderr, "host: unknown partition '%s'\n", label);
+  std::abort();
+}
+
+bool isApp(int i) { return i >= P_FACTORY && i <= P_OTA1; }
+bool isOta(int i) { return i == P_OTA0 || i == P_OTA1; }
+
+void digest(uint32_t build, uint8_t salt, uint8_t out[32]) {
+  uint32_t x = build * 2654435761u + salt;
+  for (int i = 0; i < 32; ++i) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    out[i] = static_cast<uint8_t>(x);
+  }
+}
+
+void elfSha(uint32_t build, uint8_t out[32]) { digest(build, 0x11, out); }
+
+bool bootable(int i) {
+  const Slot& s = dev().slots[i];
+  if (!s.present) return false;
+  return !(isOta(i) && (s.state == ESP_OTA_IMG_INVALID || s.state == ESP_OTA_IMG_ABORTED));
+}
+
+//==================== NVS ====================
+
+Device::Handle* handleOf(nvs_handle_t h) {
+  Device& d = dev();
+  if (h == 0 || h > d.handles.size() || !d.handles[h - 1].open) return nullptr;
+  return &d.handles[h - 1];
+}
+
+esp_err_t setValue(nvs_handle_t h, const char* key, nvs_type_t type, const void* value, size_t len) {
+  Device::Handle* handle = handleOf(h);
+  if (!handle) return ESP_ERR_NVS_INVALID_HANDLE;
+  if (handle->readOnly) return ESP_ERR_NVS_READ_ONLY;
+  if (!key || std::strlen(key) >= NVS_KEY_NAME_MAX_SIZE) return ESP_ERR_NVS_KEY_TOO_LONG;
+  const uint8_t* bytes = static_cast<const uint8_t*>(value);
+  dev().nvs[handle->ns][key] = {type, std::vector<uint8_t>(bytes, bytes + len)};
+  return ESP_OK;
+}
+
+// NVS looks entries up by key and type, like the real one.
+const std::vector<uint8_t>* findValue(nvs_handle_t h, const char* key, nvs_type_t type, esp_err_t& err) {
+  Device::Handle* handle = handleOf(h);
+  if (!handle) {
+    err = ESP_ERR_NVS_INVALID_HANDLE;
+    return nullptr;
+  }
+  auto& entries = dev().nvs[handle->ns];
+  auto it = entries.find(key ? key : "");
+  if (it == entries.end() || (type != NVS_TYPE_ANY && it->second.first != type)) {
+    err = ESP_ERR_NVS_NOT_FOUND;
+    return nullptr;
+  }
+  err = ESP_OK;
+  return &it->second.second;
+}
+
+esp_err_t getVariable(nvs_handle_t h, const char* key, nvs_type_t type, void* out, size_t* length) {
+  esp_err_t err;
+  const std::vector<uint8_t>* value = findValue(h, key, type, err);
+  if (!value) return err;
+  if (!length) return ESP_ERR_INVALID_ARG;
+  if (!out) {
+    *length = value->size();
+    return ESP_OK;
+  }
+  if (*length < value->size()) return ESP_ERR_NVS_INVALID_LENGTH;
+  std::memcpy(out, value->data(), value->size());
+  *length = value->size();
+  return ESP_OK;
+}
+
+template <typename T>
+esp_err_t getFixed(nvs_handle_t h, const char* key, nvs_type_t type, T* out) {
+  esp_err_t err;
+  const std::vector<uint8_t>* value = findValue(h, key, type, err);
+  if (!value) return err;
+  std::memcpy(out, value->data(), sizeof(T));
+  return ESP_OK;
+}
+
+} // namespace
+
+namespace crg {
+namespace host {
+
+void reset() {
+  g_initialized = true;
+  Device& d = device();
+  d = Device{};
+  for (int i = 0; i < P_COUNT; ++i) {
+    if (!isApp(i)) d.data[i].assign(kParts[i].size, 0xFF);
+  }
+  d.slots[P_FACTORY] = Slot{true, 1, ESP_OTA_IMG_UNDEFINED};
+  d.slots[P_OTA0] = Slot{true, 1, ESP_OTA_IMG_VALID};
+  std::memset(&crg::detail::rtcState, 0xA5, sizeof(crg::detail::rtcState));
+}
+
+void setRollbackEnabled(bool enabled) {
+  Device& d = dev();
+  d.rollback = enabled;
+  for (int i = P_OTA0; i <= P_OTA1; ++i) {
+    if (d.slots[i].present) d.slots[i].state = enabled ? ESP_OTA_IMG_VALID : ESP_OTA_IMG_UNDEFINED;
+  }
+}
+
+void writeImage(const char* label, uint32_t build) {
+  const int i = indexOf(label);
+  if (!isApp(i)) std::abort();
+  dev().slots[i] = Slot{true, build, ESP_OTA_IMG_UNDEFINED};
+}
+
+void imageDigest(uint32_t build, uint8_t out[32]) { digest(build, 0x22, out); }
+
+const esp_partition_t* writeUpdate(uint32_t build) {
+  const esp_partition_t* target = esp_ota_get_next_update_partition(nullptr);
+  writeImage(target->label, build);
+  return target;
+}
+
+const esp_partition_t* installUpdate(uint32_t build) {
+  const esp_partition_t* target = writeUpdate(build);
+  esp_ota_set_boot_partition(target);
+  return target;
+}
+
+void reboot(esp_reset_reason_t reason) {
+  Device& d = dev();
+  d.reason = reason;
+  d.early = false;
+  d.nowUs = 0;
+  if (reason == ESP_RST_POWERON) {
+    std::memset(&crg::detail::rtcState, 0xA5, sizeof(crg::detail::rtcState));
+  }
+
+  int boot = d.boot;
+  if (d.rollback && isOta(boot)) {
+    Slot& slot = d.slots[boot];
+    if (slot.state == ESP_OTA_IMG_PENDING_VERIFY) {
+      // The image reset before it was confirmed.
+      slot.state = ESP_OTA_IMG_ABORTED;
+    } else if (slot.state == ESP_OTA_IMG_NEW) {
+      slot.state = ESP_OTA_IMG_PENDING_VERIFY;
+    }
+  }
+  if (!bootable(boot)) {
+    const int other = (boot == P_OTA0) ? P_OTA1 : P_OTA0;
+    boot = bootable(other) ? other : P_FACTORY;
+  }
+  d.boot = boot;
+  d.running = boot;
+}
+
+void crash(uint32_t pc, const uint32_t* backtrace, uint8_t depth) {
+  Device& d = dev();
+  esp_core_dump_summary_t& s = d.dump;
+  std::memset(&s, 0, sizeof(s));
+  s.exc_pc = pc;
+  s.exc_bt_info.depth = depth > 16 ? 16 : depth;
+  for (uint32_t i = 0; i < s.exc_bt_info.depth; ++i) {
+    s.exc_bt_info.bt[i] = backtrace[i];
+  }
+  esp_ota_get_app_elf_sha256(reinterpret_cast<char*>(s.app_elf_sha256), sizeof(s.app_elf_sha256));
+  // Stacks and timers differ between two dumps of the same crash, and so does
+  // the checksum at the end of the image.
+  d.dumpImage.assign(kDumpSize, 0);
+  digest(++d.dumpSeq, 0x33, d.dumpImage.data() + kDumpSize - 32);
+  d.dumpPresent = true;
+  reboot(ESP_RST_PANIC);
+}
+
+bool coreDumpPresent() { return dev().dumpPresent; }
+
+void advanceMs(uint32_t ms) { dev().nowUs += static_cast<int64_t>(ms) * 1000; }
+
+const char* runningLabel() { return kParts[dev().running].label; }
+
+uint32_t runningBuild() { return dev().slots[dev().running].build; }
+
+esp_ota_img_states_t imageState(const char* label) {
+  const int i = indexOf(label);
+  return isApp(i) ? dev().slots[i].state : ESP_OTA_IMG_UNDEFINED;
+}
+
+void earlyReset(soc_reset_reason_t rom, esp_reset_reason_t hint) {
+  reboot(rom == RESET_REASON_CHIP_POWER_ON ? ESP_RST_POWERON : ESP_RST_UNKNOWN);
+  Device& d = dev();
+  d.early = true;
+  d.romReason = rom;
+  d.hint = hint;
+}
+
+uint32_t restarts() { return dev().restarts; }
+
+} // namespace host
+} // namespace crg
+
+//==================== esp_system / esp_timer / esp_log ====================
+
+esp_reset_reason_t esp_reset_reason(void) { return dev().early ? ESP_RST_UNKNOWN : dev().reason; }
+
+esp_reset_reason_t esp_reset_reason_get_hint(void) { return dev().hint; }
+
+soc_reset_reason_t esp_rom_get_reset_reason(int) { return dev().romReason; }
+
+void esp_restart(void) {
+  ++dev().restarts;
+  throw crg::host::Restart{};
+}
+
+int64_t esp_timer_get_time(void) { return dev().nowUs; }
+
+void esp_log_write(esp_log_level_t, const char*, const char* format, ...) {
+  if (!std::getenv("CRG_HOST_LOG")) return;
+  va_list args;
+  va_start(args, format);
+  std::vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+//==================== Partitions ====================
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char* label) {
+  for (const esp_partition_t& p : kParts) {
+    if (type != ESP_PARTITION_TYPE_ANY && p.type != type) continue;
+    if (subtype != ESP_PARTITION_SUBTYPE_ANY && p.subtype != subtype) continue;
+    if (label && std::strcmp(label, p.label) != 0) continue;
+    return &p;
+  }
+  return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+  const int i = indexOf(partition);
+  if (i < 0 || isApp(i)) return ESP_ERR_INVALID_ARG;
+  if (src_offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+  std::memcpy(dst, dev().data[i].data() + src_offset, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+  const int i = indexOf(partition);
+  if (i < 0 || isApp(i)) return ESP_ERR_INVALID_ARG;
+  if (dst_offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+  // NOR flash: programming can only clear bits.
+  uint8_t* mem = dev().data[i].data() + dst_offset;
+  const uint8_t* bytes = static_cast<const uint8_t*>(src);
+  for (size_t k = 0; k < size; ++k) mem[k] &= bytes[k];
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  const int i = indexOf(partition);
+  if (i < 0 || isApp(i)) return ESP_ERR_INVALID_ARG;
+  if (offset % kSector || size % kSector) return ESP_ERR_INVALID_SIZE;
+  if (offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+  std::memset(dev().data[i].data() + offset, 0xFF, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_get_sha256(const esp_partition_t* partition, uint8_t* sha_256) {
+  const int i = indexOf(partition);
+  if (i < 0 || !isApp(i) || !dev().slots[i].present) return ESP_ERR_INVALID_ARG;
+  crg::host::imageDigest(dev().slots[i].build, sha_256);
+  return ESP_OK;
+}
+
+//==================== OTA ====================
+
+const esp_partition_t* esp_ota_get_running_partition(void) { return &kParts[dev().running]; }
+
+const esp_partition_t* esp_ota_get_boot_partition(void) { return &kParts[dev().boot]; }
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from) {
+  const int from = start_from ? indexOf(start_from) : dev().running;
+  return &kParts[from == P_OTA0 ? P_OTA1 : P_OTA0];
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+  const int i = indexOf(partition);
+  if (i < 0 || !isApp(i)) return ESP_ERR_INVALID_ARG;
+  Device& d = dev();
+  if (!d.slots[i].present) return ESP_ERR_OTA_VALIDATE_FAILED;
+  if (isOta(i)) d.slots[i].state = d.rollback ? ESP_OTA_IMG_NEW : ESP_OTA_IMG_UNDEFINED;
+  d.boot = i;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t* partition, esp_ota_img_states_t* ota_state) {
+  const int i = indexOf(partition);
+  if (i < 0 || !isOta(i) || !ota_state) return ESP_ERR_NOT_SUPPORTED;
+  if (!dev().slots[i].present) return ESP_ERR_NOT_FOUND;
+  *ota_state = dev().slots[i].state;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_get_partition_description(const esp_partition_t* partition, esp_app_desc_t* app_desc) {
+  const int i = indexOf(partition);
+  if (i < 0 || !isApp(i) || !app_desc) return ESP_ERR_INVALID_ARG;
+  if (!dev().slots[i].present) return ESP_ERR_NOT_FOUND;
+  std::memset(app_desc, 0, sizeof(*app_desc));
+  app_desc->magic_word = 0xABCD5432;
+  std::snprintf(app_desc->version, sizeof(app_desc->version), "build-%u", (unsigned)dev().slots[i].build);
+  elfSha(dev().slots[i].build, app_desc->app_elf_sha256);
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void) {
+  Device& d = dev();
+  if (isOta(d.running)) d.slots[d.running].state = ESP_OTA_IMG_VALID;
+  return ESP_OK;
+}
+
+int esp_ota_get_app_elf_sha256(char* dst, size_t size) {
+  if (!dst || size == 0) return 0;
+  uint8_t sha[32];
+  elfSha(dev().slots[dev().running].build, sha);
+  size_t n = 0;
+  for (; n + 1 < size && n < 64; ++n) {
+    static const char hex[] = "0123456789abcdef";
+    dst[n] = hex[(n & 1) ? (sha[n / 2] & 0x0F) : (sha[n / 2] >> 4)];
+  }
+  dst[n] = '\0';
+  return static_cast<int>(n + 1);
+}
+
+//==================== Core dump ====================
+
+esp_err_t esp_core_dump_get_summary(esp_core_dump_summary_t* summary) {
+  if (!summary) return ESP_ERR_INVALID_ARG;
+  if (!dev().dumpPresent) return ESP_ERR_NOT_FOUND;
+  *summary = dev().dump;
+  return ESP_OK;
+}
+
+esp_err_t esp_core_dump_image_get(size_t* out_addr, size_t* out_size) {
+  if (!out_addr || !out_size) return ESP_ERR_INVALID_ARG;
+  if (!dev().dumpPresent) return ESP_ERR_NOT_FOUND;
+  *out_addr = kDumpAddr;
+  *out_size = dev().dumpImage.size();
+  return ESP_OK;
+}
+
+esp_err_t esp_core_dump_image_erase(void) {
+  dev().dumpPresent = false;
+  return ESP_OK;
+}
+
+esp_err_t esp_flash_read(esp_flash_t*, void* buffer, uint32_t address, uint32_t length) {
+  // Only the core dump image is backed in main flash.
+  const Device& d = dev();
+  if (!buffer || !d.dumpPresent || address < kDumpAddr || address - kDumpAddr + length > d.dumpImage.size()) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  std::memcpy(buffer, d.dumpImage.data() + (address - kDumpAddr), length);
+  return ESP_OK;
+}
+
+//==================== NVS ====================
+
+esp_err_t nvs_flash_init(void) { return ESP_OK; }
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+  if (!name || !out_handle || std::strlen(name) >= NVS_KEY_NAME_MAX_SIZE) return ESP_ERR_NVS_INVALID_NAME;
+  Device& d = dev();
+  if (open_mode == NVS_READONLY && d.nvs.find(name) == d.nvs.end()) return ESP_ERR_NVS_NOT_FOUND;
+  d.nvs[name];
+  d.handles.push_back(Device::Handle{name, open_mode == NVS_READONLY, true});
+  *out_handle = static_cast<nvs_handle_t>(d.handles.size());
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+  if (Device::Handle* h = handleOf(handle)) h->open = false;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+  return handleOf(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* out_value) {
+  return getFixed(handle, key, NVS_TYPE_U8, out_value);
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value) {
+  return setValue(handle, key, NVS_TYPE_U8, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value) {
+  return getFixed(handle, key, NVS_TYPE_U32, out_value);
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value) {
+  return setValue(handle, key, NVS_TYPE_U32, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length) {
+  return getVariable(handle, key, NVS_TYPE_STR, out_value, length);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+  if (!value) return ESP_ERR_INVALID_ARG;
+  return setValue(handle, key, NVS_TYPE_STR, value, std::strlen(value) + 1);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length) {
+  return getVariable(handle, key, NVS_TYPE_BLOB, out_value, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+  if (!value) return ESP_ERR_INVALID_ARG;
+  return setValue(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_find_key(nvs_handle_t handle, const char* key, nvs_type_t* out_type) {
+  esp_err_t err;
+  if (!findValue(handle, key, NVS_TYPE_ANY, err)) return err;
+  if (out_type) *out_type = dev().nvs[handleOf(handle)->ns][key].first;
+  return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+  Device::Handle* h = handleOf(handle);
+  if (!h) return ESP_ERR_NVS_INVALID_HANDLE;
+  if (h->readOnly) return ESP_ERR_NVS_READ_ONLY;
+  return dev().nvs[h->ns].erase(key ? key : "") ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+  Device::Handle* h = handleOf(handle);
+  if (!h) return ESP_ERR_NVS_INVALID_HANDLE;
+  if (h->readOnly) return ESP_ERR_NVS_READ_ONLY;
+  dev().nvs[h->ns].clear();
+  return ESP_OK;
+}
+
+//==================== FreeRTOS ====================
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buffer) {
+  buffer->count = 0;
+  return buffer;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t* buffer) {
+  buffer->count = 0;
+  return buffer;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t) {
+  if (!sem || sem->count != 0) return pdFALSE; // would deadlock on a single thread
+  sem->count = 1;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  if (!sem || sem->count != 1) return pdFALSE;
+  sem->count = 0;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t) {
+  if (!sem) return pdFALSE;
+  ++sem->count;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+  if (!sem || sem->count == 0) return pdFALSE;
+  --sem->count;
+  return pdTRUE;
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                                           UBaseType_t, StackType_t*, StaticTask_t* tcb, BaseType_t) {
+  fn(arg);
+  return tcb;
+}
+
+void vTaskDelete(TaskHandle_t) {}
+
+BaseType_t xTaskGetSchedulerState(void) { return taskSCHEDULER_RUNNING; }
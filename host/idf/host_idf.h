@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_ota_ops.h"
+#include "esp_rom_sys.h"
+#include "esp_system.h"
+
+// Control side of the host stand-ins: a device with factory, ota_0 and ota_1
+// app slots, an "nvs" and a "crglog" (8 KB) data partition, and a bootloader
+// that behaves like CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE.
+
+namespace crg {
+namespace host {
+
+// Thrown by esp_restart(). Catch it and call reboot().
+struct Restart {};
+
+// Factory-fresh device: empty NVS, erased data partitions, build 1 in factory
+// and ota_0, ota_0 running and VALID, clock at 0, no core dump.
+void reset();
+
+// false = bootloader without app rollback (every image state is UNDEFINED).
+void setRollbackEnabled(bool enabled);
+
+// Image identity: ELF SHA-256 and partition SHA-256 are derived from build.
+void writeImage(const char* label, uint32_t build);
+void imageDigest(uint32_t build, uint8_t out[32]);
+// Writes build into the next update slot without activating it (esp_ota_end()).
+const esp_partition_t* writeUpdate(uint32_t build);
+// Same plus esp_ota_set_boot_partition(), like Arduino Update.end().
+const esp_partition_t* installUpdate(uint32_t build);
+
+// Reset: the bootloader picks the slot (NEW -> PENDING_VERIFY, an unconfirmed
+// PENDING_VERIFY -> ABORTED and back to the other slot), the clock restarts.
+// RTC memory survives everything except ESP_RST_POWERON.
+void reboot(esp_reset_reason_t reason);
+// Panic of the running image with a core dump summary, then reboot(ESP_RST_PANIC).
+void crash(uint32_t pc, const uint32_t* backtrace, uint8_t depth);
+// Reset seen from the early boot hook: esp_reset_reason() is still
+// ESP_RST_UNKNOWN, only the ROM reason and the RTC hint are available.
+void earlyReset(soc_reset_reason_t rom, esp_reset_reason_t hint);
+bool coreDumpPresent();
+
+void advanceMs(uint32_t ms);
+
+const char* runningLabel();
+uint32_t runningBuild();
+esp_ota_img_states_t imageState(const char* label);
+uint32_t restarts();
+
+} // namespace host
+} // namespace crg
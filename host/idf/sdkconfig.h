@@ -0,0 +1,8 @@
+#pragma once
+
+// Host build configuration: core dumps to flash in ELF format on an Xtensa
+// target, so the guard reads crash summaries through host::crash().
+#define CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH 1
+#define CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF 1
+#define CONFIG_IDF_TARGET_ARCH_XTENSA 1
+#define CONFIG_APP_RETRIEVE_LEN_ELF_SHA 9
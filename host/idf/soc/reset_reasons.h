@@ -0,0 +1,18 @@
+#pragma once
+
+// ROM reset reasons as numbered on the ESP32-S3 (the host is no ESP32, so
+// the CPU0_MWDT1 reason exists).
+typedef enum {
+  RESET_REASON_CHIP_POWER_ON   = 0x01,
+  RESET_REASON_CORE_SW         = 0x03,
+  RESET_REASON_CORE_DEEP_SLEEP = 0x05,
+  RESET_REASON_CORE_MWDT0      = 0x07,
+  RESET_REASON_CORE_MWDT1      = 0x08,
+  RESET_REASON_CORE_RTC_WDT    = 0x09,
+  RESET_REASON_CPU0_MWDT0      = 0x0B,
+  RESET_REASON_CPU0_SW         = 0x0C,
+  RESET_REASON_CPU0_RTC_WDT    = 0x0D,
+  RESET_REASON_SYS_BROWN_OUT   = 0x0F,
+  RESET_REASON_SYS_RTC_WDT     = 0x10,
+  RESET_REASON_CPU0_MWDT1      = 0x11,
+} soc_reset_reason_t;
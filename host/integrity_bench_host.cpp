@@ -0,0 +1,101 @@
+// Host version of examples/integrity_bench: the same backends and record
+// sizes, timed with std::chrono. Exits 1 when a backend disagrees with the
+// bitwise reference or the zlib check value; timings are informational.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <random>
+
+#include "CrashRollbackGuard.h"
+
+struct Backend {
+  const char* name;
+  uint32_t (*fn)(const void*, size_t, uint32_t);
+};
+
+static const Backend BACKENDS[] = {
+  {"bitwise", crg::integrity::crc32Bitwise},
+  {"table",   crg::integrity::crc32Table},
+  {"slice8",  crg::integrity::crc32Slice8},
+};
+
+// What the guard hashes: each record up to its crc field (components only
+// hash the counters), taken from the record types so the sizes cannot drift;
+// then a 256 B block and a 4 KiB image chunk.
+struct Size {
+  const char* what;
+  size_t size;
+};
+
+static const Size SIZES[] = {
+  {"label",     CRG_LABEL_BUFFER_SIZE - 1},
+#if CRG_FEATURE_COMPONENTS
+  {"component", sizeof(crg::detail::ComponentRecord::fails)},
+#endif
+#if CRG_FEATURE_CRASH_SIGNATURE
+  {"signature", offsetof(crg::detail::SignatureRecord, crc)},
+#endif
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  {"upStats",   offsetof(crg::detail::UptimeStatsRecord, crc)},
+#endif
+  {"otaTx",     offsetof(crg::detail::OtaTxRecord, crc)},
+  {"block",     256},
+  {"image",     4096},
+};
+
+constexpr uint32_t TARGET_BYTES = 4 * 1024 * 1024; // work per measurement
+
+static uint8_t buffer[4096];
+
+int main() {
+  bool pass = true;
+
+  static const char check[] = "123456789";
+  for (const Backend& backend : BACKENDS) {
+    // Whole buffer and split in two must both give the zlib check value.
+    const uint32_t whole = backend.fn(check, 9, 0);
+    const uint32_t split = backend.fn(check + 4, 5, backend.fn(check, 4, 0));
+    if (whole != 0xCBF43926u || split != whole) {
+      std::printf("%s: check value %08lx/%08lx\n", backend.name,
+                  static_cast<unsigned long>(whole), static_cast<unsigned long>(split));
+      pass = false;
+    }
+  }
+
+  std::mt19937 rng(1);
+  for (uint8_t& b : buffer) {
+    b = static_cast<uint8_t>(rng());
+  }
+
+  std::printf("record,size,backend,ns_per_call,mb_per_s,crc\n");
+  for (const Size& entry : SIZES) {
+    const size_t size = entry.size;
+    const uint32_t reference = crg::integrity::crc32Bitwise(buffer, size, 0);
+    const uint32_t iterations = TARGET_BYTES / size;
+
+    for (const Backend& backend : BACKENDS) {
+      volatile uint32_t sink = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < iterations; ++i) {
+        sink = backend.fn(buffer, size, sink & 1u); // keep calls dependent
+      }
+      const double elapsedNs = static_cast<double>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+      const uint32_t crc = backend.fn(buffer, size, 0);
+      const bool ok = crc == reference;
+      pass = pass && ok;
+      std::printf("%s,%u,%s,%.1f,%.1f,%08lx%s\n",
+                  entry.what,
+                  static_cast<unsigned>(size),
+                  backend.name,
+                  elapsedNs / iterations,
+                  elapsedNs > 0 ? (static_cast<double>(size) * iterations * 1000.0) / elapsedNs : 0.0,
+                  static_cast<unsigned long>(crc),
+                  ok ? "" : " MISMATCH");
+    }
+  }
+  return pass ? 0 : 1;
+}
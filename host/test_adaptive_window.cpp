@@ -0,0 +1,109 @@
+// Adaptive stable window on the host stand-ins: markServicesUp() only
+// timestamps, loopTick() validates at the learned window, and a boot that
+// crashes before validation contributes no readiness sample.
+
+#include "CrashRollbackGuard.h"
+#include "host_idf.h"
+#include "host_test.h"
+
+namespace {
+
+constexpr uint32_t kServicesUpMs = 3000;
+constexpr uint32_t kTickMs = 100;
+
+crg::Options options() {
+  crg::Options opt;
+  opt.stableTimeMs = 60000;
+  opt.adaptiveStableTime = true;
+  opt.stableTimeMinMs = 5000;
+  opt.stableTimeMarginMs = 4000;
+  opt.logLevel = crg::LogLevel::None;
+  return opt;
+}
+
+// Runs loopTick() until the image is validated; returns the uptime then.
+uint32_t runUntilValid(crg::CrashRollbackGuard& guard, const char* label) {
+  uint32_t uptime = 0;
+  while (crg::host::imageState(label) != ESP_OTA_IMG_VALID && uptime < 120000) {
+    crg::host::advanceMs(kTickMs);
+    uptime += kTickMs;
+    if (uptime == kServicesUpMs) guard.markServicesUp();
+    guard.loopTick();
+  }
+  return uptime;
+}
+
+// Every boot runs a freshly installed image, so validation is observable.
+uint32_t bootNewImage(uint32_t build, uint32_t* window = nullptr) {
+  crg::host::installUpdate(build);
+  crg::host::reboot(ESP_RST_SW);
+  crg::CrashRollbackGuard guard;
+  guard.setOptions(options());
+  guard.beginEarly();
+  CHECK(crg::host::imageState(crg::host::runningLabel()) == ESP_OTA_IMG_PENDING_VERIFY);
+  guard.loopTick(); // post-boot stage loads the statistics
+  if (window) *window = guard.stableWindowMs();
+  return runUntilValid(guard, crg::host::runningLabel());
+}
+
+void servicesUpDoesNotValidate() {
+  crg::host::reset();
+  crg::host::installUpdate(2);
+  crg::host::reboot(ESP_RST_SW);
+  crg::CrashRollbackGuard guard;
+  guard.setOptions(options());
+  guard.beginEarly();
+  crg::host::advanceMs(kServicesUpMs);
+  guard.markServicesUp();
+  guard.loopTick();
+  CHECK(crg::host::imageState(crg::host::runningLabel()) == ESP_OTA_IMG_PENDING_VERIFY);
+}
+
+void learnsWindowFromReadiness() {
+  crg::host::reset();
+  uint32_t build = 2;
+
+  // Until CRG_STATS_MIN_SAMPLES boots are validated, the fixed window applies.
+  for (int i = 0; i < CRG_STATS_MIN_SAMPLES; ++i) {
+    uint32_t window = 0;
+    CHECK(bootNewImage(build++, &window) == options().stableTimeMs);
+    CHECK(window == options().stableTimeMs);
+  }
+
+  uint32_t window = 0;
+  const uint32_t validatedAt = bootNewImage(build++, &window);
+  CHECK(window == kServicesUpMs + options().stableTimeMarginMs);
+  CHECK(validatedAt == window);
+}
+
+void crashBeforeValidationIsNotASample() {
+  crg::host::reset();
+  crg::host::setRollbackEnabled(false); // keep running the same image after a crash
+  crg::Options opt = options();
+  opt.failLimit = 10;
+
+  for (int i = 0; i < CRG_STATS_MIN_SAMPLES; ++i) {
+    crg::CrashRollbackGuard guard;
+    guard.setOptions(opt);
+    guard.beginEarly();
+    crg::host::advanceMs(kServicesUpMs);
+    guard.markServicesUp();
+    guard.loopTick();
+    crg::host::reboot(ESP_RST_PANIC); // before the window: readiness is not kept
+  }
+
+  crg::CrashRollbackGuard guard;
+  guard.setOptions(opt);
+  guard.beginEarly();
+  guard.loopTick();
+  CHECK(guard.stableWindowMs() == opt.stableTimeMs);
+}
+
+} // namespace
+
+int main() {
+  servicesUpDoesNotValidate();
+  learnsWindowFromReadiness();
+  crashBeforeValidationIsNotASample();
+  return host_test::result();
+}
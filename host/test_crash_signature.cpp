@@ -0,0 +1,155 @@
+// Crash signatures on the host stand-ins: a deterministic panic on an image
+// that was never marked healthy rolls back after signatureRepeatLimit hits,
+// a core dump is kept in flash but never counted twice, a proven image goes through
+// the regular failLimit path, and maxRollbackAttempts caps both paths.
+
+#include <cstring>
+
+#include "CrashRollbackGuard.h"
+#include "host_idf.h"
+#include "host_test.h"
+
+namespace {
+
+const uint32_t kBacktrace[] = {0x400d1234, 0x400d2000, 0x400e0010};
+
+crg::Options options() {
+  crg::Options opt;
+  opt.failLimit = 5;
+  opt.signatureRepeatLimit = 2;
+  opt.logLevel = crg::LogLevel::None;
+  return opt;
+}
+
+// One boot of the application: beginEarly(), then the caller's body. A
+// rollback ends in esp_restart(), which the bootloader stand-in completes.
+crg::Decision boot(bool markHealthy = false, uint32_t* signature = nullptr) {
+  crg::CrashRollbackGuard guard;
+  guard.setOptions(options());
+  try {
+    const crg::Decision d = guard.beginEarly();
+    if (signature) *signature = guard.lastCrashSignature();
+    if (markHealthy) guard.markHealthyNow();
+    return d;
+  } catch (const crg::host::Restart&) {
+    crg::host::reboot(ESP_RST_SW);
+    return crg::Decision::RollbackToPrev;
+  }
+}
+
+void crash() { crg::host::crash(0x400d1234, kBacktrace, 3); }
+
+// Build 1 in ota_0 is proven and saved as prev; build 2 goes to ota_1.
+void installBuild2() {
+  crg::host::reset();
+  crg::host::setRollbackEnabled(false);
+  {
+    crg::CrashRollbackGuard guard;
+    guard.setOptions(options());
+    guard.beginEarly();
+    guard.saveCurrentAsPreviousSlot();
+    guard.markHealthyNow();
+  }
+  crg::host::installUpdate(2);
+  crg::host::reboot(ESP_RST_SW);
+  CHECK(crg::host::runningBuild() == 2);
+  CHECK(crg::host::imageState("ota_1") == ESP_OTA_IMG_UNDEFINED);
+}
+
+void repeatedSignatureOnUnprovenImage() {
+  installBuild2();
+  CHECK(boot() == crg::Decision::None);
+
+  crash();
+  uint32_t first = 0;
+  CHECK(boot(false, &first) == crg::Decision::None);
+  CHECK(first != 0);
+  CHECK(crg::host::coreDumpPresent()); // left for the app to upload
+
+  crash();
+  CHECK(boot() == crg::Decision::RollbackToPrev);
+  CHECK(crg::host::runningBuild() == 1);
+}
+
+void staleDumpIsNotCountedAgain() {
+  installBuild2();
+  crash();
+  CHECK(boot() == crg::Decision::None);
+
+  // Watchdog resets without a new dump: the counted one must not count again.
+  for (int i = 0; i < 2; ++i) {
+    crg::host::reboot(ESP_RST_TASK_WDT);
+    uint32_t sig = 1;
+    CHECK(boot(false, &sig) == crg::Decision::None);
+    CHECK(sig == 0);
+  }
+  CHECK(crg::host::runningBuild() == 2);
+}
+
+void staleDumpAfterHealthyMark() {
+  installBuild2();
+  crash();
+  CHECK(boot(true) == crg::Decision::None);
+
+  // The table starts over with the health mark, the dump is still in flash.
+  crg::host::reboot(ESP_RST_TASK_WDT);
+  uint32_t sig = 1;
+  CHECK(boot(false, &sig) == crg::Decision::None);
+  CHECK(sig == 0);
+  CHECK(crg::host::coreDumpPresent());
+}
+
+void provenImageUsesFailLimit() {
+  installBuild2();
+  CHECK(boot(true) == crg::Decision::None);
+
+  for (uint32_t i = 1; i < options().failLimit; ++i) {
+    crash();
+    CHECK(boot() == crg::Decision::None);
+    CHECK(crg::host::runningBuild() == 2);
+  }
+  crash();
+  CHECK(boot() == crg::Decision::RollbackToPrev);
+  CHECK(crg::host::runningBuild() == 1);
+}
+
+void otherImageDumpIsIgnored() {
+  installBuild2();
+  crash();
+  // The dump belongs to build 2; build 3 must not count it.
+  crg::host::writeImage("ota_1", 3);
+  crg::host::reboot(ESP_RST_PANIC);
+  uint32_t sig = 1;
+  CHECK(boot(false, &sig) == crg::Decision::None);
+  CHECK(sig == 0);
+}
+
+void rollbackLimitAppliesToSignatures() {
+  installBuild2();
+  crash();
+  CHECK(boot() == crg::Decision::None);
+  crash();
+  CHECK(boot() == crg::Decision::RollbackToPrev);
+  CHECK(crg::host::runningBuild() == 1);
+
+  // Build 2 is activated again without a health mark in between: the next
+  // repeat must hit maxRollbackAttempts instead of rolling back once more.
+  esp_ota_set_boot_partition(esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, "ota_1"));
+  crg::host::reboot(ESP_RST_SW);
+  CHECK(crg::host::runningBuild() == 2);
+  crash();
+  CHECK(boot() == crg::Decision::SkippedNoPrev);
+  CHECK(crg::host::runningBuild() == 2);
+}
+
+} // namespace
+
+int main() {
+  repeatedSignatureOnUnprovenImage();
+  staleDumpIsNotCountedAgain();
+  staleDumpAfterHealthyMark();
+  provenImageUsesFailLimit();
+  otherImageDumpIsIgnored();
+  rollbackLimitAppliesToSignatures();
+  return host_test::result();
+}
@@ -0,0 +1,68 @@
+// Early boot hook on the host stand-ins: before esp_reset_reason() is
+// initialized the guard decodes the ROM reset reason plus the RTC hint, so
+// watchdog resets keep their type and still count as crashes.
+
+#include "CrashRollbackGuard.h"
+#include "host_idf.h"
+#include "host_test.h"
+
+namespace {
+
+struct Case {
+  soc_reset_reason_t rom;
+  esp_reset_reason_t hint;
+  esp_reset_reason_t expected;
+};
+
+const Case kCases[] = {
+  {RESET_REASON_CHIP_POWER_ON, ESP_RST_UNKNOWN,  ESP_RST_POWERON},
+  {RESET_REASON_CORE_SW,       ESP_RST_UNKNOWN,  ESP_RST_SW},
+  {RESET_REASON_CPU0_SW,       ESP_RST_PANIC,    ESP_RST_PANIC},
+  {RESET_REASON_CORE_MWDT0,    ESP_RST_UNKNOWN,  ESP_RST_TASK_WDT},
+  {RESET_REASON_CORE_MWDT1,    ESP_RST_UNKNOWN,  ESP_RST_TASK_WDT},
+  {RESET_REASON_CPU0_MWDT0,    ESP_RST_UNKNOWN,  ESP_RST_TASK_WDT},
+  {RESET_REASON_CPU0_MWDT1,    ESP_RST_UNKNOWN,  ESP_RST_TASK_WDT},
+  {RESET_REASON_CORE_MWDT1,    ESP_RST_INT_WDT,  ESP_RST_INT_WDT},
+  {RESET_REASON_CPU0_MWDT0,    ESP_RST_PANIC,    ESP_RST_PANIC},
+  {RESET_REASON_CORE_RTC_WDT,  ESP_RST_UNKNOWN,  ESP_RST_WDT},
+  {RESET_REASON_CPU0_RTC_WDT,  ESP_RST_UNKNOWN,  ESP_RST_WDT},
+  {RESET_REASON_SYS_RTC_WDT,   ESP_RST_UNKNOWN,  ESP_RST_WDT},
+};
+
+crg::Options options() {
+  crg::Options opt;
+  opt.failLimit = 5;
+  opt.logLevel = crg::LogLevel::None;
+  return opt;
+}
+
+void decodesRomReason() {
+  for (const Case& c : kCases) {
+    crg::host::reset();
+    crg::host::earlyReset(c.rom, c.hint);
+    crg::CrashRollbackGuard guard;
+    guard.setOptions(options());
+    guard.beginEarly();
+    CHECK(guard.lastResetReason() == c.expected);
+  }
+}
+
+// A watchdog reset without a hint is a crash, not an unknown reset.
+void watchdogCountsAsCrash() {
+  crg::host::reset();
+  for (uint32_t boot = 1; boot <= 2; ++boot) {
+    crg::host::earlyReset(boot == 1 ? RESET_REASON_CORE_MWDT0 : RESET_REASON_SYS_RTC_WDT, ESP_RST_UNKNOWN);
+    crg::CrashRollbackGuard guard;
+    guard.setOptions(options());
+    guard.beginEarly();
+    CHECK(guard.failCount() == boot);
+  }
+}
+
+} // namespace
+
+int main() {
+  decodesRomReason();
+  watchdogCountsAsCrash();
+  return host_test::result();
+}
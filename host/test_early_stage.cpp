@@ -0,0 +1,115 @@
+// RTC stage with several guards on the host stand-ins: each namespace stages
+// into its own slot, a reset before persistEarly() is caught up by the next
+// boot of the same guard only, and a guard without a free slot still persists.
+
+#include "CrashRollbackGuard.h"
+#include "host_idf.h"
+#include "host_test.h"
+
+namespace {
+
+crg::Options options(const char* ns) {
+  crg::Options opt;
+  opt.nvsNamespace = ns;
+  opt.failLimit = 5;
+  opt.logLevel = crg::LogLevel::None;
+  return opt;
+}
+
+// Fail counter as stored in NVS (the guard has not decided this boot).
+uint32_t storedFails(const char* ns) {
+  crg::CrashRollbackGuard guard;
+  guard.setOptions(options(ns));
+  return guard.failCount();
+}
+
+void twoGuardsKeepTheirCounts() {
+  crg::host::reset();
+  crg::host::reboot(ESP_RST_TASK_WDT);
+  {
+    crg::CrashRollbackGuard a, b;
+    a.setOptions(options("nsA"));
+    b.setOptions(options("nsB"));
+    a.decideEarly();
+    b.decideEarly();
+    CHECK(a.failCount() == 1 && b.failCount() == 1);
+  } // reset before either persistEarly()
+
+  crg::host::reboot(ESP_RST_TASK_WDT);
+  {
+    crg::CrashRollbackGuard a, b;
+    a.setOptions(options("nsA"));
+    b.setOptions(options("nsB"));
+    b.decideEarly(); // must not flush nsA's stage into nsB
+    a.decideEarly();
+    CHECK(b.persistEarly() && a.persistEarly());
+  }
+  CHECK(storedFails("nsA") == 2);
+  CHECK(storedFails("nsB") == 2);
+}
+
+void otherStageStaysInPlace() {
+  crg::host::reset();
+  crg::host::reboot(ESP_RST_TASK_WDT);
+  {
+    crg::CrashRollbackGuard a;
+    a.setOptions(options("nsA"));
+    a.decideEarly();
+  }
+
+  // A boot that runs only the guard of nsB leaves nsA's stage alone.
+  crg::host::reboot(ESP_RST_TASK_WDT);
+  {
+    crg::CrashRollbackGuard b;
+    b.setOptions(options("nsB"));
+    b.beginEarly();
+  }
+  CHECK(storedFails("nsA") == 0);
+  CHECK(storedFails("nsB") == 1);
+
+  crg::host::reboot(ESP_RST_TASK_WDT);
+  {
+    crg::CrashRollbackGuard a;
+    a.setOptions(options("nsA"));
+    a.beginEarly();
+  }
+  CHECK(storedFails("nsA") == 2);
+  CHECK(storedFails("nsB") == 1);
+}
+
+void guardWithoutSlotStillPersists() {
+  crg::host::reset();
+  crg::host::reboot(ESP_RST_TASK_WDT);
+  {
+    crg::CrashRollbackGuard a, b, c;
+    a.setOptions(options("nsA"));
+    b.setOptions(options("nsB"));
+    c.setOptions(options("nsC"));
+    a.decideEarly();
+    b.decideEarly();
+    c.decideEarly(); // CRG_EARLY_STAGE_SLOTS == 2: stages in RAM
+    CHECK(c.failCount() == 1);
+    CHECK(c.persistEarly());
+  }
+  CHECK(storedFails("nsC") == 1);
+
+  crg::host::reboot(ESP_RST_TASK_WDT);
+  {
+    crg::CrashRollbackGuard a, b;
+    a.setOptions(options("nsA"));
+    b.setOptions(options("nsB"));
+    a.beginEarly();
+    b.beginEarly();
+  }
+  CHECK(storedFails("nsA") == 2);
+  CHECK(storedFails("nsB") == 2);
+}
+
+} // namespace
+
+int main() {
+  twoGuardsKeepTheirCounts();
+  otherStageStaysInPlace();
+  guardWithoutSlotStillPersists();
+  return host_test::result();
+}
@@ -0,0 +1,196 @@
+// Flash-log backend on the NOR simulator (flash_sim.h): persistence across
+// remounts, power cuts at every byte of an append and during a sector erase,
+// wear over 1000 commits, garbage flash and payload capacity.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "CrgStore.h"
+#include "flash_sim.h"
+#include "host_test.h"
+
+namespace {
+
+using crg::Store;
+using crg::host::PowerCut;
+using crg::host::flashSim;
+using crg::host::remountFlash;
+
+uint32_t readFails() {
+  Store s;
+  s.begin("crg", true);
+  return s.getUInt("fails");
+}
+
+void writeFails(uint32_t value) {
+  Store s;
+  s.begin("crg", false);
+  s.putUInt("fails", value);
+  s.end();
+}
+
+// Runs one commit that is cut by the simulator; returns false if it finished.
+bool cutCommit(uint32_t value) {
+  try {
+    writeFails(value);
+  } catch (const PowerCut&) {
+    return true;
+  }
+  return false;
+}
+
+void persistence() {
+  crg::host::installFlashSim();
+  {
+    Store s;
+    CHECK(s.begin("crg", false));
+    CHECK(s.putUInt("fails", 7) == 4);
+    CHECK(s.putUChar("pendAct", 2) == 1);
+    CHECK(s.putString("prev", "ota_0") == 5);
+    s.end();
+  }
+  {
+    Store s;
+    s.begin("other", false);
+    s.putUInt("fails", 1);
+    s.end();
+  }
+  remountFlash();
+  {
+    Store s;
+    CHECK(s.begin("crg", true));
+    CHECK(s.getUInt("fails") == 7);
+    CHECK(s.getUChar("pendAct") == 2);
+    char label[17];
+    CHECK(s.getString("prev", label, sizeof(label)) == 6 && std::strcmp(label, "ota_0") == 0);
+    CHECK(s.getUInt("pendAct", 99) == 99); // wrong size reads as missing
+    CHECK(s.putUInt("x", 1) == 0);         // read-only
+  }
+  {
+    Store s;
+    s.begin("other", false);
+    CHECK(s.clear());
+    s.end();
+  }
+  remountFlash();
+  CHECK(readFails() == 7);
+  {
+    Store s;
+    s.begin("other", true);
+    CHECK(!s.isKey("fails"));
+  }
+
+  // An unchanged value does not append an entry.
+  const uint32_t writes = flashSim().writes;
+  writeFails(7);
+  CHECK(flashSim().writes == writes);
+}
+
+void powerCutDuringAppend() {
+  crg::host::installFlashSim();
+  writeFails(100);
+  for (long cut = 0; cut < static_cast<long>(crg::flashlog::ENTRY_SIZE); ++cut) {
+    const uint32_t before = readFails();
+    flashSim().cutAfterWrite = cut;
+    CHECK(cutCommit(before + 1));
+
+    remountFlash();
+    const uint32_t after = readFails();
+    // Old value, or the new one once everything but the erased tail is written.
+    CHECK(after == before || (after == before + 1 && cut >= 16));
+
+    // The torn slot is skipped, never programmed over.
+    writeFails(after + 2);
+    remountFlash();
+    CHECK(readFails() == after + 2);
+  }
+  CHECK(flashSim().overwrites == 0);
+}
+
+void powerCutDuringErase() {
+  crg::host::installFlashSim();
+  const long cuts[] = {0, 1, 100, 2048, 4095};
+  uint32_t value = 1;
+  for (long cut : cuts) {
+    // Fill the active sector so the next commit has to erase the other one.
+    while (crg::flashlog::info().nextSlot < crg::flashlog::SLOTS_PER_SECTOR) {
+      writeFails(value++);
+    }
+    const uint32_t before = readFails();
+    flashSim().cutAfterErase = cut;
+    CHECK(cutCommit(before + 1));
+
+    remountFlash();
+    CHECK(readFails() == before);
+    writeFails(before + 5);
+    remountFlash();
+    CHECK(readFails() == before + 5);
+    value = before + 6;
+  }
+}
+
+void wear() {
+  crg::host::installFlashSim();
+  constexpr uint32_t kCommits = 1000;
+  for (uint32_t i = 1; i <= kCommits; ++i) {
+    writeFails(i);
+    if (i % 97 == 0) remountFlash();
+  }
+  remountFlash();
+  CHECK(readFails() == kCommits);
+
+  const uint32_t* erases = flashSim().sectorErases;
+  const uint32_t total = erases[0] + erases[1];
+  const uint32_t expected = kCommits / crg::flashlog::SLOTS_PER_SECTOR;
+  std::printf("wear: %u commits, %u erases (sector0=%u sector1=%u), %u overwrites\n",
+              static_cast<unsigned>(kCommits), static_cast<unsigned>(total),
+              static_cast<unsigned>(erases[0]), static_cast<unsigned>(erases[1]),
+              static_cast<unsigned>(flashSim().overwrites));
+  CHECK(total + 1 >= expected && total <= expected + 1);
+  CHECK(erases[0] + 1 >= erases[1] && erases[1] + 1 >= erases[0]);
+  CHECK(flashSim().overwrites == 0);
+}
+
+void garbageAndCapacity() {
+  crg::host::FlashSim& sim = crg::host::installFlashSim();
+  std::srand(1);
+  for (uint8_t& b : sim.mem) {
+    b = static_cast<uint8_t>(std::rand());
+  }
+  remountFlash();
+  {
+    Store s;
+    CHECK(s.begin("crg", false));
+    CHECK(!s.isKey("fails"));
+    s.putUInt("fails", 3);
+    s.end();
+  }
+  remountFlash();
+  CHECK(readFails() == 3);
+
+  Store s;
+  s.begin("crg", false);
+  uint8_t big[crg::flashlog::ENTRY_SIZE] = {};
+  CHECK(s.putBytes("big", big, sizeof(big)) == 0);
+  CHECK(s.putBytes("big", big, 300) == 300);
+  s.end();
+
+  // Mount cost: one header read per slot plus the newest entry.
+  remountFlash();
+  const uint32_t reads = sim.reads;
+  CHECK(readFails() == 3);
+  std::printf("mount: %u flash reads\n", static_cast<unsigned>(sim.reads - reads));
+  CHECK(sim.reads - reads <= 2 * crg::flashlog::SLOTS_PER_SECTOR + 1);
+}
+
+} // namespace
+
+int main() {
+  persistence();
+  powerCutDuringAppend();
+  powerCutDuringErase();
+  wear();
+  garbageAndCapacity();
+  return host_test::result();
+}
@@ -0,0 +1,140 @@
+// OTA transactions on the host stand-ins, with an OTA writer that activates
+// the new slot itself (Arduino Update.end()) before commitOtaTransaction().
+
+#include <cstring>
+
+#include "CrashRollbackGuard.h"
+#include "host_idf.h"
+#include "host_test.h"
+
+namespace {
+
+crg::Options options() {
+  crg::Options opt;
+  opt.failLimit = 2;
+  opt.swResetCountsAsCrash = true; // an unannounced restart counts
+  opt.logLevel = crg::LogLevel::None;
+  return opt;
+}
+
+struct Boot {
+  crg::Decision decision = crg::Decision::None;
+  uint32_t fails = 0;
+  bool hasPrev = false;
+  char prev[CRG_LABEL_BUFFER_SIZE] = {};
+};
+
+Boot boot() {
+  Boot b;
+  crg::CrashRollbackGuard guard;
+  guard.setOptions(options());
+  try {
+    b.decision = guard.beginEarly();
+  } catch (const crg::host::Restart&) {
+    crg::host::reboot(ESP_RST_SW);
+    b.decision = crg::Decision::RollbackToPrev;
+    return b;
+  }
+  b.fails = guard.failCount();
+  b.hasPrev = guard.getPreviousSlot(b.prev, sizeof(b.prev));
+  return b;
+}
+
+// Build 1 runs in ota_0 with a booted guard; the caller drives the update.
+void start(bool rollback) {
+  crg::host::reset();
+  crg::host::setRollbackEnabled(rollback);
+  boot();
+}
+
+void committedUpdate() {
+  start(true);
+  uint8_t digest[32];
+  crg::host::imageDigest(2, digest);
+  {
+    crg::CrashRollbackGuard guard;
+    guard.setOptions(options());
+    guard.beginEarly();
+    CHECK(guard.beginOtaTransaction(nullptr, digest));
+    crg::host::installUpdate(2);
+    CHECK(guard.commitOtaTransaction());
+  }
+  crg::host::reboot(ESP_RST_SW);
+  CHECK(crg::host::runningBuild() == 2);
+  const Boot b = boot();
+  CHECK(b.fails == 0); // the restart was announced by the commit
+  CHECK(b.hasPrev && std::strcmp(b.prev, "ota_0") == 0);
+}
+
+void resetBetweenActivationAndCommit() {
+  start(false);
+  {
+    crg::CrashRollbackGuard guard;
+    guard.setOptions(options());
+    guard.beginEarly();
+    CHECK(guard.beginOtaTransaction());
+    crg::host::installUpdate(2); // Update.end() already switched the boot slot
+  }
+  crg::host::reboot(ESP_RST_SW); // before commitOtaTransaction()
+  CHECK(crg::host::runningBuild() == 2);
+
+  Boot b = boot();
+  CHECK(b.fails == 1); // no restart intent without a commit
+  CHECK(b.hasPrev && std::strcmp(b.prev, "ota_0") == 0);
+
+  // The new image crash-loops: the guard knows where to go back to.
+  crg::host::reboot(ESP_RST_PANIC);
+  b = boot();
+  CHECK(b.decision == crg::Decision::RollbackToPrev);
+  CHECK(crg::host::runningBuild() == 1);
+}
+
+void failedVerificationStaysOnCurrent() {
+  start(true);
+  uint8_t digest[32];
+  crg::host::imageDigest(3, digest); // not what gets written
+  {
+    crg::CrashRollbackGuard guard;
+    guard.setOptions(options());
+    guard.beginEarly();
+    CHECK(guard.beginOtaTransaction(nullptr, digest));
+    crg::host::installUpdate(2);
+    CHECK(!guard.commitOtaTransaction());
+  }
+  crg::host::reboot(ESP_RST_SW);
+  CHECK(crg::host::runningBuild() == 1);
+  CHECK(!boot().hasPrev);
+}
+
+void abortAndInterruptedDownload() {
+  start(true);
+  {
+    crg::CrashRollbackGuard guard;
+    guard.setOptions(options());
+    guard.beginEarly();
+    CHECK(guard.beginOtaTransaction());
+    guard.abortOtaTransaction();
+  }
+  crg::host::reboot(ESP_RST_POWERON);
+  CHECK(!boot().hasPrev);
+
+  {
+    crg::CrashRollbackGuard guard;
+    guard.setOptions(options());
+    guard.beginEarly();
+    CHECK(guard.beginOtaTransaction());
+  }
+  crg::host::reboot(ESP_RST_POWERON); // power lost while downloading
+  CHECK(crg::host::runningBuild() == 1);
+  CHECK(!boot().hasPrev);
+}
+
+} // namespace
+
+int main() {
+  committedUpdate();
+  resetBetweenActivationAndCommit();
+  failedVerificationStaysOnCurrent();
+  abortAndInterruptedDownload();
+  return host_test::result();
+}
@@ -1,11 +1,73 @@
 #include "CrashRollbackGuard.h"
 #include <cstdarg>
+#include <cstddef>
+#include <cstdio>
 #include <cstring>
 
+#if CRG_FEATURE_CRASH_SIGNATURE && defined(CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH) && defined(CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF)
+  #include "esp_core_dump.h"
+  #include "esp_flash.h"
+  #define CRG_HAS_CORE_DUMP_SUMMARY 1
+#else
+  #define CRG_HAS_CORE_DUMP_SUMMARY 0
+#endif
+
+#if !CRG_ARDUINO
+  #include "esp_log.h"
+#endif
+
+#if CRG_STORAGE_BACKEND == CRG_STORAGE_FLASHLOG
+  #include "CrgFlashLog.h"
+#endif
+
+#if CRG_EARLY_BOOT_HOOK
+  #include "nvs_flash.h"
+  #include "esp_rom_sys.h"
+  #include "esp_private/system_internal.h"
+#endif
+
 namespace crg {
 
+namespace detail {
+RTC_NOINIT_ATTR RtcState rtcState;
+} // namespace detail
+
+#if CRG_STORAGE_BACKEND == CRG_STORAGE_FLASHLOG
+namespace {
+// Every key one guard can hold at once, each behind its flash-log record
+// header. Labels are counted at their maximum length.
+constexpr size_t flashlogRecord(size_t valueLen) { return flashlog::RECORD_HEADER + valueLen; }
+
+constexpr size_t kFlashlogGuardBytes =
+    2 * flashlogRecord(sizeof(uint32_t))        // fails, failsInv
+  + 2 * flashlogRecord(CRG_LABEL_BUFFER_SIZE)   // prev, pendLbl
+  + 2 * flashlogRecord(sizeof(uint32_t))        // prevCrc, pendCrc
+  + 3 * flashlogRecord(sizeof(uint8_t))         // rbCnt, rbCntInv, pendAct
+  + flashlogRecord(sizeof(detail::OtaTxRecord))
+#if CRG_FEATURE_ADAPTIVE_STABLE || CRG_FEATURE_CRASH_SIGNATURE
+  + flashlogRecord(sizeof(uint32_t))            // okImage
+#endif
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  + flashlogRecord(sizeof(detail::UptimeStatsRecord))
+#endif
+#if CRG_FEATURE_CRASH_SIGNATURE
+  + flashlogRecord(sizeof(detail::SignatureRecord))
+#endif
+#if CRG_FEATURE_COMPONENTS
+  + flashlogRecord(sizeof(detail::ComponentRecord))
+#endif
+  ;
+
+static_assert(kFlashlogGuardBytes <= flashlog::PAYLOAD_SIZE,
+              "guard records do not fit one flash-log entry: raise CRG_FLASHLOG_ENTRY_SIZE");
+} // namespace
+#endif
+
 CrashRollbackGuard::CrashRollbackGuard() {
   setOptions(Options{});
+#if CRG_FEATURE_CRASH_SIGNATURE && CRG_HAS_CORE_DUMP_SUMMARY
+  crashSummaryProvider_ = &CrashRollbackGuard::readCoreDumpSummary_;
+#endif
 }
 
 void CrashRollbackGuard::setOptions(const Options& opt) {
@@ -28,13 +90,12 @@ void CrashRollbackGuard::setOptions(const Options& opt) {
   opt_.factoryLabel = (ownedFactoryLabel_[0] == '\0') ? nullptr : ownedFactoryLabel_;
 
 #if CRG_FEATURE_FACTORY_FALLBACK
+  // Partition table lookup is not needed to decide on rollback, so it is
+  // deferred to runPostBoot(); tryFactoryFallback_() re-checks on demand.
   if (opt_.fallbackToFactory) {
-    if (!opt_.factoryLabel || !findAppPartitionByLabel_(opt_.factoryLabel)) {
-      log(LogLevel::Error,
-          "[CRG] factory fallback disabled: partition '%s' not found.\n",
-          opt_.factoryLabel ? opt_.factoryLabel : "<unset>");
-      opt_.fallbackToFactory = false;
-    }
+    postBootTasks_ |= PB_VALIDATE_FACTORY;
+  } else {
+    postBootTasks_ &= static_cast<uint8_t>(~PB_VALIDATE_FACTORY);
   }
 #endif
 }
@@ -44,11 +105,24 @@ void CrashRollbackGuard::setSuspiciousResetPredicate(ResetReasonPredicate pred)
   suspiciousPred_ = pred;
 }
 
+void CrashRollbackGuard::setIntegrityFunction(IntegrityFn fn) {
+  integrityFn_ = fn ? fn : &integrity::crc32;
+}
+
+#if CRG_FEATURE_CRASH_SIGNATURE
+void CrashRollbackGuard::setCrashSummaryProvider(CrashSummaryProvider provider) {
+  crashSummaryProvider_ = provider;
+}
+#endif
+
 esp_reset_reason_t CrashRollbackGuard::lastResetReason() const { return resetReason_; }
 
 uint32_t CrashRollbackGuard::failCount() const {
+  if (earlyDecided_ && (stageFlags_() & STAGE_FAILS)) {
+    return stage_->fails;
+  }
   // prefs_ может быть не открыт до beginEarly(), поэтому читаем безопасно
-  Preferences tmp;
+  Store tmp;
   if (!tmp.begin(opt_.nvsNamespace, true)) return 0;
   const uint32_t v = readFailCounter_(tmp, false);
   tmp.end();
@@ -75,20 +149,32 @@ bool CrashRollbackGuard::isSuspicious(esp_reset_reason_t r) const {
 void CrashRollbackGuard::log(LogLevel lvl, const char* fmt, ...) const {
   if ((uint8_t)opt_.logLevel < (uint8_t)lvl || lvl == LogLevel::None) return;
 
-  if (!opt_.logOutput) return;
   char buf[CRG_LOG_BUFFER_SIZE];
   va_list args;
   va_start(args, fmt);
   vsnprintf(buf, sizeof(buf), fmt, args);
   va_end(args);
 
-  opt_.logOutput->print(buf);
+  if (opt_.logSink) {
+    opt_.logSink(buf, opt_.logArg);
+    return;
+  }
+#if CRG_ARDUINO
+  Serial.print(buf);
+#else
+  // Messages carry their own "[CRG]" prefix and newline, so write them raw.
+  const esp_log_level_t level = (lvl == LogLevel::Error) ? ESP_LOG_ERROR
+                              : (lvl == LogLevel::Info)  ? ESP_LOG_INFO
+                                                         : ESP_LOG_DEBUG;
+  esp_log_write(level, "CRG", "%s", buf);
+#endif
 }
 
 bool CrashRollbackGuard::getRunningLabel(char* out, size_t len) {
   return readRunningLabel_(out, len);
 }
 
+#if CRG_ARDUINO
 String CrashRollbackGuard::getRunningLabel() {
   char label[CRG_LABEL_BUFFER_SIZE];
   if (!getRunningLabel(label, sizeof(label))) {
@@ -96,6 +182,7 @@ String CrashRollbackGuard::getRunningLabel() {
   }
   return String(label);
 }
+#endif
 
 const esp_partition_t* CrashRollbackGuard::findAppPartitionByLabel_(const char* label) {
   if (!label || !label[0]) return nullptr;
@@ -134,24 +221,15 @@ bool CrashRollbackGuard::readRunningLabel_(char* out, size_t len) {
   return true;
 }
 
-bool CrashRollbackGuard::storeLabelPref_(Preferences& store, const char* key, const char* value) {
+bool CrashRollbackGuard::storeLabelPref_(Store& store, const char* key, const char* value) {
   if (!key || !value) return false;
   return store.putString(key, value) > 0;
 }
-uint32_t CrashRollbackGuard::crc32_(const void* data, size_t len) {
-  const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
-  uint32_t crc = 0xFFFFFFFFu;
-  while (len--) {
-    crc ^= *ptr++;
-    for (uint8_t i = 0; i < 8; ++i) {
-      const uint32_t mask = -(crc & 1u);
-      crc = (crc >> 1) ^ (0xEDB88320u & mask);
-    }
-  }
-  return crc ^ 0xFFFFFFFFu;
+uint32_t CrashRollbackGuard::crc32_(const void* data, size_t len) const {
+  return integrityFn_(data, len);
 }
 
-bool CrashRollbackGuard::storeLabelWithCrc_(Preferences& store,
+bool CrashRollbackGuard::storeLabelWithCrc_(Store& store,
                                             const char* labelKey,
                                             const char* crcKey,
                                             const char* value) const {
@@ -172,11 +250,11 @@ bool CrashRollbackGuard::storeLabelWithCrc_(Preferences& store,
   return true;
 }
 
-CrashRollbackGuard::LabelStatus CrashRollbackGuard::loadLabelWithCrc_(Preferences& store,
+CrashRollbackGuard::LabelStatus CrashRollbackGuard::loadLabelWithCrc_(Store& store,
                                                                       const char* labelKey,
                                                                       const char* crcKey,
                                                                       char* out,
-                                                                      size_t len) {
+                                                                      size_t len) const {
   if (!labelKey || !crcKey || !out || len == 0) return LabelStatus::Missing;
   out[0] = '\0';
   const size_t got = store.getString(labelKey, out, len);
@@ -198,10 +276,12 @@ CrashRollbackGuard::LabelStatus CrashRollbackGuard::loadLabelWithCrc_(Preference
   return LabelStatus::Ok;
 }
 
-uint32_t CrashRollbackGuard::readFailCounter_(Preferences& store, bool allowRepair) const {
+uint32_t CrashRollbackGuard::readFailCounter_(Store& store, bool allowRepair, bool* corrupted) const {
   const uint32_t primary = store.getUInt(K_FAILS, 0);
   const uint32_t mirror  = store.getUInt(K_FAILS_INV, primary ^ 0xFFFFFFFFu);
-  if ((primary ^ mirror) != 0xFFFFFFFFu) {
+  const bool bad = (primary ^ mirror) != 0xFFFFFFFFu;
+  if (corrupted) *corrupted = bad;
+  if (bad) {
     log(LogLevel::Error, "[CRG] fail counter corrupted (0x%08x vs 0x%08x).\n", primary, mirror);
     if (allowRepair) {
       writeFailCounter_(store, 0);
@@ -211,16 +291,16 @@ uint32_t CrashRollbackGuard::readFailCounter_(Preferences& store, bool allowRepa
   return primary;
 }
 
-void CrashRollbackGuard::writeFailCounter_(Preferences& store, uint32_t value) const {
+void CrashRollbackGuard::writeFailCounter_(Store& store, uint32_t value) const {
   store.putUInt(K_FAILS, value);
   store.putUInt(K_FAILS_INV, value ^ 0xFFFFFFFFu);
 }
 
-void CrashRollbackGuard::resetFailCounter_(Preferences& store) const {
+void CrashRollbackGuard::resetFailCounter_(Store& store) const {
   writeFailCounter_(store, 0);
 }
 
-uint8_t CrashRollbackGuard::readRollbackCount_(Preferences& store, bool allowRepair) const {
+uint8_t CrashRollbackGuard::readRollbackCount_(Store& store, bool allowRepair) const {
   const uint8_t primary = store.getUChar(K_ROLL_COUNT, 0);
   const uint8_t mirror  = store.getUChar(K_ROLL_COUNT_INV, primary ^ 0xFFu);
   if ((uint8_t)(primary ^ mirror) != 0xFFu) {
@@ -233,23 +313,23 @@ uint8_t CrashRollbackGuard::readRollbackCount_(Preferences& store, bool allowRep
   return primary;
 }
 
-void CrashRollbackGuard::writeRollbackCount_(Preferences& store, uint8_t value) const {
+void CrashRollbackGuard::writeRollbackCount_(Store& store, uint8_t value) const {
   store.putUChar(K_ROLL_COUNT, value);
   store.putUChar(K_ROLL_COUNT_INV, value ^ 0xFFu);
 }
 
-void CrashRollbackGuard::resetRollbackCount_(Preferences& store) const {
+void CrashRollbackGuard::resetRollbackCount_(Store& store) const {
   writeRollbackCount_(store, 0);
 }
 
-void CrashRollbackGuard::bumpRollbackCount_(Preferences& store) const {
+void CrashRollbackGuard::bumpRollbackCount_(Store& store) const {
   const uint8_t current = readRollbackCount_(store);
   if (current != 0xFFu) {
     writeRollbackCount_(store, current + 1);
   }
 }
 
-void CrashRollbackGuard::storePendingAction_(Preferences& store, PendingAction action, const char* label) const {
+void CrashRollbackGuard::storePendingAction_(Store& store, PendingAction action, const char* label) const {
   // Ensure action is cleared before writing label data so partially written labels
   // never pair with a stale PendingAction value.
   if (store.putUChar(K_PENDING_ACT, static_cast<uint8_t>(PendingAction::None)) == 0) {
@@ -275,7 +355,7 @@ void CrashRollbackGuard::storePendingAction_(Preferences& store, PendingAction a
   }
 }
 
-CrashRollbackGuard::PendingAction CrashRollbackGuard::readPendingAction_(Preferences& store,
+CrashRollbackGuard::PendingAction CrashRollbackGuard::readPendingAction_(Store& store,
                                                                          char* labelBuf,
                                                                          size_t bufLen) const {
   if (labelBuf && bufLen > 0) {
@@ -322,14 +402,534 @@ CrashRollbackGuard::PendingAction CrashRollbackGuard::readPendingAction_(Prefere
   return action;
 }
 
-void CrashRollbackGuard::clearPendingAction_(Preferences& store) const {
+void CrashRollbackGuard::clearPendingAction_(Store& store) const {
   store.putUChar(K_PENDING_ACT, static_cast<uint8_t>(PendingAction::None));
   store.remove(K_PENDING_LABEL);
   store.remove(K_PENDING_CRC);
 }
 
+#if CRG_FEATURE_ADAPTIVE_STABLE || CRG_FEATURE_CRASH_SIGNATURE
+uint32_t CrashRollbackGuard::currentImageTag_() {
+  if (imageTag_ != 0) return imageTag_;
+  esp_app_desc_t desc;
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  if (running && esp_ota_get_partition_description(running, &desc) == ESP_OK) {
+    imageTag_ = integrity::crc32(desc.app_elf_sha256, sizeof(desc.app_elf_sha256));
+  }
+  if (imageTag_ == 0) imageTag_ = 1;
+  return imageTag_;
+}
+#endif
+
+#if CRG_FEATURE_CRASH_SIGNATURE
+bool CrashRollbackGuard::readCoreDumpSummary_(CrashSummary& out) {
+#if CRG_HAS_CORE_DUMP_SUMMARY
+  esp_core_dump_summary_t summary;
+  if (esp_core_dump_get_summary(&summary) != ESP_OK) return false;
+
+  // A dump left behind by another image says nothing about this one.
+  char elfSha[sizeof(summary.app_elf_sha256)];
+  esp_ota_get_app_elf_sha256(elfSha, sizeof(elfSha));
+  if (strncmp(elfSha, reinterpret_cast<const char*>(summary.app_elf_sha256), sizeof(elfSha)) != 0) {
+    return false;
+  }
+
+  out = CrashSummary{};
+  out.pc = summary.exc_pc;
+
+  // The dump stays in flash for the app's own upload. Its identity lets the
+  // guard skip it on a later reset that writes no new dump: the checksum at
+  // the end of the image differs between two dumps of the same crash.
+  size_t addr = 0;
+  size_t size = 0;
+  uint32_t ident[2 + 8];
+  if (esp_core_dump_image_get(&addr, &size) == ESP_OK && size >= 32 &&
+      esp_flash_read(nullptr, &ident[2], addr + size - 32, 32) == ESP_OK) {
+    ident[0] = summary.exc_tcb;
+    ident[1] = summary.exc_pc;
+    out.dumpId = integrity::crc32(ident, sizeof(ident));
+    if (out.dumpId == 0) out.dumpId = 1;
+  }
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+  const uint32_t depth = summary.exc_bt_info.depth;
+  out.depth = static_cast<uint8_t>(depth < CRG_SIGNATURE_BT_DEPTH ? depth : CRG_SIGNATURE_BT_DEPTH);
+  for (uint8_t i = 0; i < out.depth; ++i) {
+    out.backtrace[i] = summary.exc_bt_info.bt[i];
+  }
+#else
+  // RISC-V summaries carry a raw stack dump, not a decoded backtrace; the
+  // return address is the most stable frame we get for free.
+  out.backtrace[0] = summary.ex_info.ra;
+  out.depth = 1;
+#endif
+  return true;
+#else
+  (void)out;
+  return false;
+#endif
+}
+
+uint32_t CrashRollbackGuard::signatureOf_(const CrashSummary& summary) {
+  uint32_t words[1 + CRG_SIGNATURE_BT_DEPTH];
+  const uint8_t depth = summary.depth < CRG_SIGNATURE_BT_DEPTH ? summary.depth : CRG_SIGNATURE_BT_DEPTH;
+  words[0] = summary.pc;
+  for (uint8_t i = 0; i < depth; ++i) {
+    words[1 + i] = summary.backtrace[i];
+  }
+  // A signature is an identity, not an integrity check: keep it independent
+  // of setIntegrityFunction() so it stays stable across configurations.
+  const uint32_t sig = integrity::crc32(words, (1u + depth) * sizeof(uint32_t));
+  return sig != 0 ? sig : 1u; // 0 marks an empty table slot
+}
+
+void CrashRollbackGuard::loadSignatureTable_(Store& store, SignatureRecord& rec) const {
+  std::memset(&rec, 0, sizeof(rec));
+  if (store.isKey(K_CRASH_SIG) &&
+      (store.getBytes(K_CRASH_SIG, &rec, sizeof(rec)) != sizeof(rec) ||
+       rec.crc != crc32_(&rec, offsetof(SignatureRecord, crc)))) {
+    log(LogLevel::Error, "[CRG] Crash signature table corrupted. Resetting.\n");
+    std::memset(&rec, 0, sizeof(rec));
+  }
+}
+
+uint8_t CrashRollbackGuard::signatureSlot_(SignatureRecord& rec, uint32_t sig) {
+  // Known signature keeps its slot; a new one evicts the least-hit slot.
+  uint8_t slot = 0;
+  for (uint8_t i = 0; i < CRG_SIGNATURE_SLOTS; ++i) {
+    if (rec.sig[i] == sig) {
+      slot = i;
+      break;
+    }
+    if (rec.hits[i] < rec.hits[slot]) {
+      slot = i;
+    }
+  }
+  if (rec.sig[slot] != sig) {
+    rec.sig[slot] = sig;
+    rec.hits[slot] = 0;
+  }
+  return slot;
+}
+
+void CrashRollbackGuard::storeSignatureTable_(Store& store, SignatureRecord& rec) const {
+  rec.crc = crc32_(&rec, offsetof(SignatureRecord, crc));
+  if (store.putBytes(K_CRASH_SIG, &rec, sizeof(rec)) != sizeof(rec)) {
+    log(LogLevel::Error, "[CRG] Failed to write crash signature table.\n");
+  }
+}
+
+void CrashRollbackGuard::storeCrashSignature_(Store& store, uint32_t sig, uint8_t hits, uint32_t dumpId) const {
+  SignatureRecord rec;
+  loadSignatureTable_(store, rec);
+  rec.hits[signatureSlot_(rec, sig)] = hits;
+  if (dumpId != 0) rec.lastDump = dumpId;
+  storeSignatureTable_(store, rec);
+}
+
+bool CrashRollbackGuard::crashSignatureRepeated_(Store& store) {
+  crashSignature_ = 0;
+  if (opt_.signatureRepeatLimit == 0 || !crashSummaryProvider_) return false;
+  // Only these resets leave a fresh core dump behind.
+  if (resetReason_ != ESP_RST_PANIC &&
+      resetReason_ != ESP_RST_INT_WDT &&
+      resetReason_ != ESP_RST_TASK_WDT) {
+    return false;
+  }
+
+  CrashSummary summary;
+  if (!crashSummaryProvider_(summary)) return false;
+
+  SignatureRecord rec;
+  loadSignatureTable_(store, rec);
+  if (summary.dumpId != 0 && summary.dumpId == rec.lastDump) {
+    log(LogLevel::Debug, "[CRG] Core dump %08x already counted.\n", (unsigned)summary.dumpId);
+    return false;
+  }
+  crashSignature_ = signatureOf_(summary);
+  const uint8_t stored = rec.hits[signatureSlot_(rec, crashSignature_)];
+  const uint8_t hits = (stored != 0xFFu) ? stored + 1 : stored;
+
+  detail::EarlyStage& stage = *stage_;
+  stage.signature = crashSignature_;
+  stage.signatureHits = hits;
+  stage.dumpId = summary.dumpId;
+  stage.flags |= STAGE_SIGNATURE;
+
+  log(LogLevel::Info,
+      "[CRG] Crash signature %08x pc=%08x seen %u time(s).\n",
+      (unsigned)crashSignature_,
+      (unsigned)summary.pc,
+      (unsigned)hits);
+  if (hits < opt_.signatureRepeatLimit) return false;
+
+  // Only an image that has never been marked healthy is rolled back early;
+  // a proven image goes through the regular failLimit path.
+  if (store.getUInt(K_HEALTHY_IMAGE, 0) == currentImageTag_()) {
+    log(LogLevel::Info, "[CRG] Image was healthy before, signature repeat ignored.\n");
+    return false;
+  }
+  return true;
+}
+#endif
+
+void CrashRollbackGuard::takeRtcState_(uint8_t& component, uint32_t& uptimeMs) {
+  // RTC noinit memory holds garbage after power-on; the magic tells us whether
+  // the markers were written by a previous boot of this firmware.
+  const bool valid = (detail::rtcState.magic == RTC_MAGIC);
+  component = valid ? detail::rtcState.component : 0;
+  uptimeMs  = valid ? detail::rtcState.uptimeMs : 0;
+  if (component > CRG_MAX_COMPONENTS) component = 0;
+
+  // The stage survives: decideEarly() flushes what the previous boot left
+  // unwritten before it counts this reset.
+  if (!valid) {
+    std::memset(detail::rtcState.stage, 0, sizeof(detail::rtcState.stage));
+  }
+
+  detail::rtcState.magic = RTC_MAGIC;
+  detail::rtcState.component = 0;
+  detail::rtcState.uptimeMs = 0;
+}
+
+detail::EarlyStage* CrashRollbackGuard::claimStage_() {
+  // Each guard stages into the slot tagged with its namespace and leaves the
+  // slots of other guards alone: their next boot flushes them into their own
+  // namespace.
+  uint32_t owner = integrity::crc32(opt_.nvsNamespace, strlen(opt_.nvsNamespace));
+  if (owner == 0) owner = 1;
+  detail::EarlyStage* freeSlot = nullptr;
+  for (detail::EarlyStage& slot : detail::rtcState.stage) {
+    if (slot.owner == owner) return &slot;
+    if (!freeSlot && slot.flags == 0) freeSlot = &slot;
+  }
+  if (!freeSlot) {
+    log(LogLevel::Error, "[CRG] No free RTC stage slot; a reset before persistEarly() loses this boot's count.\n");
+    localStage_ = detail::EarlyStage{};
+    return &localStage_;
+  }
+  std::memset(freeSlot, 0, sizeof(*freeSlot));
+  freeSlot->owner = owner;
+  return freeSlot;
+}
+
+void CrashRollbackGuard::stageFails_(uint32_t value) {
+  detail::EarlyStage& stage = *stage_;
+  stage.fails = value;
+  stage.flags |= STAGE_FAILS;
+}
+
+void CrashRollbackGuard::flushStage_(Store& store) {
+  if (writeStage_(store)) clearStage_();
+}
+
+bool CrashRollbackGuard::writeStage_(Store& store) {
+  detail::EarlyStage& stage = *stage_;
+  const uint8_t flags = stage.flags;
+  if (flags == 0) return false;
+
+  if (flags & STAGE_OTA_TX) {
+    char runningLabel[CRG_LABEL_BUFFER_SIZE];
+    readRunningLabel_(runningLabel, sizeof(runningLabel));
+    applyOtaTx_(store, runningLabel);
+  }
+  if (flags & STAGE_CLEAR_PENDING) {
+    clearPendingAction_(store);
+  }
+  if (flags & STAGE_FAILS) {
+    writeFailCounter_(store, stage.fails);
+  }
+#if CRG_FEATURE_COMPONENTS
+  if (flags & STAGE_COMPONENT) {
+    storeComponentCount_(store, stage.component, stage.componentCount);
+  }
+#endif
+#if CRG_FEATURE_CRASH_SIGNATURE
+  if (flags & STAGE_SIGNATURE) {
+    storeCrashSignature_(store, stage.signature, stage.signatureHits, stage.dumpId);
+  }
+#endif
+
+  // Only a committed stage may be forgotten; until then a reset replays it.
+  return store.commit();
+}
+
+// The stage values are fixed once decideEarly() returns; only the flags change
+// afterwards, possibly from the persistEarlyAsync() task. Clearing them
+// publishes the flush: a task that reads 0 also sees everything written
+// before, including bootTimings().persistUs.
+void CrashRollbackGuard::clearStage_() {
+  __atomic_store_n(&stage_->flags, static_cast<uint8_t>(0), __ATOMIC_RELEASE);
+}
+
+uint8_t CrashRollbackGuard::stageFlags_() const {
+  return __atomic_load_n(&stage_->flags, __ATOMIC_ACQUIRE);
+}
+
+bool CrashRollbackGuard::earlyPersistPending() const {
+  return earlyDecided_ && stageFlags_() != 0;
+}
+
+bool CrashRollbackGuard::persistEarly() {
+  if (!earlyPersistPending()) return true;
+#if CRG_FEATURE_ASYNC_PERSIST
+  if (persistMutex_) xSemaphoreTake(persistMutex_, portMAX_DELAY);
+#endif
+
+  bool ok = true;
+  // Re-check: a background flush may have finished while we waited.
+  if (stageFlags_() != 0) {
+    const uint32_t startUs = platform::microsNow();
+    bool committed = false;
+    Store writer;
+    ok = writer.begin(opt_.nvsNamespace, false);
+    if (ok) {
+      committed = writeStage_(writer);
+      writer.end();
+    } else {
+      log(LogLevel::Error, "[CRG] NVS open failed (persist)\n");
+    }
+    bootTimings_.persistUs = platform::microsNow() - startUs;
+    if (committed) clearStage_();
+  }
+
+#if CRG_FEATURE_ASYNC_PERSIST
+  if (persistMutex_) xSemaphoreGive(persistMutex_);
+#endif
+  return ok;
+}
+
+#if CRG_FEATURE_ASYNC_PERSIST
+namespace {
+// One background flush per boot; static so the task needs no heap.
+StackType_t  s_persistStack[CRG_PERSIST_TASK_STACK];
+StaticTask_t s_persistTcb;
+bool         s_persistTaskUsed = false;
+} // namespace
+
+void CrashRollbackGuard::persistTask_(void* arg) {
+  static_cast<CrashRollbackGuard*>(arg)->persistEarly();
+  vTaskDelete(nullptr);
+}
+
+bool CrashRollbackGuard::persistEarlyAsync(UBaseType_t priority, BaseType_t core) {
+  if (!earlyPersistPending()) return true;
+  if (s_persistTaskUsed) return persistEarly();
+
+  if (!persistMutex_) {
+    persistMutex_ = xSemaphoreCreateMutexStatic(&persistMutexBuf_);
+  }
+  s_persistTaskUsed = true;
+  if (!xTaskCreateStaticPinnedToCore(&CrashRollbackGuard::persistTask_,
+                                     "crgPersist",
+                                     CRG_PERSIST_TASK_STACK,
+                                     this,
+                                     priority,
+                                     s_persistStack,
+                                     &s_persistTcb,
+                                     core)) {
+    log(LogLevel::Error, "[CRG] Persist task failed to start, flushing inline.\n");
+    return persistEarly();
+  }
+  return true;
+}
+#endif
+
+#if CRG_FEATURE_ADAPTIVE_STABLE
+namespace {
+
+uint16_t toDeciseconds(uint32_t ms) {
+  const uint32_t ds = ms / 100u;
+  if (ds == 0) return 1;
+  return ds > 0xFFFFu ? 0xFFFFu : static_cast<uint16_t>(ds);
+}
+
+} // namespace
+
+void CrashRollbackGuard::loadUptimeStats_(Store& store, UptimeStatsRecord& rec) {
+  std::memset(&rec, 0, sizeof(rec));
+  if (store.isKey(K_UPTIME_STATS) &&
+      (store.getBytes(K_UPTIME_STATS, &rec, sizeof(rec)) != sizeof(rec) ||
+       rec.crc != crc32_(&rec, offsetof(UptimeStatsRecord, crc)) ||
+       rec.healthyCount > CRG_STATS_SAMPLES || rec.healthyHead >= CRG_STATS_SAMPLES ||
+       rec.crashCount > CRG_STATS_SAMPLES / 2 || rec.crashHead >= CRG_STATS_SAMPLES / 2)) {
+    log(LogLevel::Error, "[CRG] Uptime stats corrupted. Resetting.\n");
+    std::memset(&rec, 0, sizeof(rec));
+  }
+
+  const uint32_t tag = currentImageTag_();
+  if (rec.imageTag != tag) {
+    // Time-to-healthy depends on the site and services and carries over to a
+    // new image; crash timing belongs to the image that crashed.
+    std::memset(rec.crashDs, 0, sizeof(rec.crashDs));
+    rec.crashCount = 0;
+    rec.crashHead = 0;
+    rec.imageTag = tag;
+  }
+}
+
+bool CrashRollbackGuard::storeUptimeStats_(Store& store, UptimeStatsRecord& rec) const {
+  rec.crc = crc32_(&rec, offsetof(UptimeStatsRecord, crc));
+  if (store.putBytes(K_UPTIME_STATS, &rec, sizeof(rec)) != sizeof(rec)) {
+    log(LogLevel::Error, "[CRG] Failed to write uptime stats.\n");
+    return false;
+  }
+  return true;
+}
+
+void CrashRollbackGuard::updateAdaptiveWindow_(const UptimeStatsRecord& rec) {
+  if (rec.healthyCount < CRG_STATS_MIN_SAMPLES) {
+    adaptiveStableMs_ = 0;
+    return;
+  }
+
+  uint16_t sorted[CRG_STATS_SAMPLES];
+  const uint8_t n = rec.healthyCount;
+  for (uint8_t i = 0; i < n; ++i) {
+    const uint16_t v = rec.healthyDs[i];
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > v; --j) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = v;
+  }
+
+  const uint32_t pct = opt_.stableTimePercentile > 100 ? 100 : opt_.stableTimePercentile;
+  uint32_t rank = (n * pct + 99u) / 100u; // nearest-rank percentile
+  if (rank == 0) rank = 1;
+  uint32_t windowMs = sorted[rank - 1] * 100u;
+
+  // Never validate an image earlier than it has been seen to crash.
+  for (uint8_t i = 0; i < rec.crashCount; ++i) {
+    const uint32_t crashMs = rec.crashDs[i] * 100u;
+    if (crashMs > windowMs) windowMs = crashMs;
+  }
+
+  windowMs += opt_.stableTimeMarginMs;
+  if (windowMs > opt_.stableTimeMaxMs) windowMs = opt_.stableTimeMaxMs;
+  if (windowMs < opt_.stableTimeMinMs) windowMs = opt_.stableTimeMinMs;
+  adaptiveStableMs_ = windowMs ? windowMs : 1;
+
+  log(LogLevel::Debug,
+      "[CRG] Adaptive stable window %lu ms (%u healthy, %u crash samples).\n",
+      (unsigned long)adaptiveStableMs_,
+      (unsigned)rec.healthyCount,
+      (unsigned)rec.crashCount);
+}
+
+void CrashRollbackGuard::recordHealthySample_(Store& store, uint32_t elapsedMs) {
+  UptimeStatsRecord rec;
+  loadUptimeStats_(store, rec);
+  rec.healthyDs[rec.healthyHead] = toDeciseconds(elapsedMs);
+  rec.healthyHead = static_cast<uint8_t>((rec.healthyHead + 1u) % CRG_STATS_SAMPLES);
+  if (rec.healthyCount < CRG_STATS_SAMPLES) ++rec.healthyCount;
+  storeUptimeStats_(store, rec);
+  updateAdaptiveWindow_(rec);
+}
+
+void CrashRollbackGuard::refreshUptimeStats_(Store& store) {
+  UptimeStatsRecord rec;
+  loadUptimeStats_(store, rec);
+  if (crashUptimeMs_ != 0) {
+    rec.crashDs[rec.crashHead] = toDeciseconds(crashUptimeMs_);
+    rec.crashHead = static_cast<uint8_t>((rec.crashHead + 1u) % (CRG_STATS_SAMPLES / 2));
+    if (rec.crashCount < CRG_STATS_SAMPLES / 2) ++rec.crashCount;
+    storeUptimeStats_(store, rec);
+    log(LogLevel::Info, "[CRG] Crashed after %lu ms without health mark.\n", (unsigned long)crashUptimeMs_);
+  }
+  updateAdaptiveWindow_(rec);
+}
+#endif
+
+#if CRG_FEATURE_COMPONENTS
+bool CrashRollbackGuard::loadComponentRecord_(Store& store, ComponentRecord& rec) const {
+  std::memset(&rec, 0, sizeof(rec));
+  if (!store.isKey(K_COMP_FAILS)) return true;
+  if (store.getBytes(K_COMP_FAILS, &rec, sizeof(rec)) != sizeof(rec) ||
+      rec.crc != crc32_(rec.fails, sizeof(rec.fails))) {
+    log(LogLevel::Error, "[CRG] Component record corrupted. Resetting.\n");
+    std::memset(&rec, 0, sizeof(rec));
+    return false;
+  }
+  return true;
+}
+
+bool CrashRollbackGuard::storeComponentRecord_(Store& store, ComponentRecord& rec) const {
+  rec.crc = crc32_(rec.fails, sizeof(rec.fails));
+  if (store.putBytes(K_COMP_FAILS, &rec, sizeof(rec)) != sizeof(rec)) {
+    log(LogLevel::Error, "[CRG] Failed to write component record.\n");
+    return false;
+  }
+  return true;
+}
+
+bool CrashRollbackGuard::componentCrashAbsorbed_(Store& store, uint8_t id) {
+  if (id == 0 || id > CRG_MAX_COMPONENTS) return false;
+  ComponentRecord rec;
+  loadComponentRecord_(store, rec);
+  const uint8_t stored = rec.fails[id - 1];
+  const bool absorbed = stored < opt_.componentFailLimit;
+  const uint8_t count = (stored != 0xFFu) ? stored + 1 : stored;
+
+  detail::EarlyStage& stage = *stage_;
+  stage.component = id;
+  stage.componentCount = count;
+  stage.flags |= STAGE_COMPONENT;
+
+  log(LogLevel::Error,
+      "[CRG] Crash attributed to component %u (count=%u limit=%u).\n",
+      (unsigned)id,
+      (unsigned)count,
+      (unsigned)opt_.componentFailLimit);
+  return absorbed;
+}
+
+void CrashRollbackGuard::storeComponentCount_(Store& store, uint8_t id, uint8_t count) const {
+  if (id == 0 || id > CRG_MAX_COMPONENTS) return;
+  ComponentRecord rec;
+  loadComponentRecord_(store, rec);
+  rec.fails[id - 1] = count;
+  storeComponentRecord_(store, rec);
+}
+
+uint8_t CrashRollbackGuard::componentFailCount(uint8_t id) const {
+  if (id == 0 || id > CRG_MAX_COMPONENTS) return 0;
+  if (earlyDecided_ && (stageFlags_() & STAGE_COMPONENT) && stage_->component == id) {
+    return stage_->componentCount;
+  }
+  Store reader;
+  if (!reader.begin(opt_.nvsNamespace, true)) return 0;
+  ComponentRecord rec;
+  loadComponentRecord_(reader, rec);
+  reader.end();
+  return rec.fails[id - 1];
+}
+
+bool CrashRollbackGuard::componentDisabled(uint8_t id) const {
+  return opt_.componentFailLimit > 0 && componentFailCount(id) >= opt_.componentFailLimit;
+}
+
+void CrashRollbackGuard::clearComponentFailures(uint8_t id) {
+  if (id > CRG_MAX_COMPONENTS) return;
+  persistEarly();
+  Store writer;
+  if (!writer.begin(opt_.nvsNamespace, false)) return;
+  if (id == 0) {
+    writer.remove(K_COMP_FAILS);
+  } else {
+    ComponentRecord rec;
+    loadComponentRecord_(writer, rec);
+    if (rec.fails[id - 1] != 0) {
+      rec.fails[id - 1] = 0;
+      storeComponentRecord_(writer, rec);
+    }
+  }
+  writer.end();
+}
+#endif
+
 bool CrashRollbackGuard::saveCurrentAsPreviousSlot() {
-  Preferences writer;
+  persistEarly();
+  Store writer;
   if (!writer.begin(opt_.nvsNamespace, false)) return false;
 
   char label[CRG_LABEL_BUFFER_SIZE];
@@ -352,7 +952,7 @@ bool CrashRollbackGuard::getPreviousSlot(char* out, size_t len) const {
   if (!out || len == 0) return false;
   out[0] = '\0';
 
-  Preferences reader;
+  Store reader;
   if (!reader.begin(opt_.nvsNamespace, true)) return false;
 
   const LabelStatus status = loadLabelWithCrc_(reader, K_PREV_LABEL, K_PREV_CRC, out, len);
@@ -360,7 +960,7 @@ bool CrashRollbackGuard::getPreviousSlot(char* out, size_t len) const {
 
   if (status == LabelStatus::Corrupted) {
     log(LogLevel::Error, "[CRG] Stored prev slot label corrupted. Clearing.\n");
-    Preferences writer;
+    Store writer;
     if (writer.begin(opt_.nvsNamespace, false)) {
       writer.remove(K_PREV_LABEL);
       writer.remove(K_PREV_CRC);
@@ -378,6 +978,7 @@ bool CrashRollbackGuard::getPreviousSlot(char* out, size_t len) const {
   return true;
 }
 
+#if CRG_ARDUINO
 String CrashRollbackGuard::getPreviousSlot() const {
   char label[CRG_LABEL_BUFFER_SIZE];
   if (!getPreviousSlot(label, sizeof(label))) {
@@ -385,9 +986,11 @@ String CrashRollbackGuard::getPreviousSlot() const {
   }
   return String(label);
 }
+#endif
 
 void CrashRollbackGuard::clearPreviousSlot() {
-  Preferences writer;
+  persistEarly();
+  Store writer;
   if (!writer.begin(opt_.nvsNamespace, false)) return;
   writer.remove(K_PREV_LABEL);
   writer.remove(K_PREV_CRC);
@@ -395,10 +998,187 @@ void CrashRollbackGuard::clearPreviousSlot() {
   writer.end();
 }
 
+bool CrashRollbackGuard::beginOtaTransaction(const esp_partition_t* target, const uint8_t* expectedSha256) {
+  otaTxActive_ = false;
+  std::memset(&otaTx_, 0, sizeof(otaTx_));
+
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  if (!target) {
+    target = esp_ota_get_next_update_partition(nullptr);
+  }
+  if (!running || !target || target == running || target->type != ESP_PARTITION_TYPE_APP) {
+    log(LogLevel::Error, "[CRG] OTA transaction: no usable target slot.\n");
+    return false;
+  }
+
+  otaTx_.version = OTA_TX_VERSION;
+  copyLabel_(otaTx_.prevLabel, sizeof(otaTx_.prevLabel), running->label);
+  copyLabel_(otaTx_.targetLabel, sizeof(otaTx_.targetLabel), target->label);
+  if (expectedSha256) {
+    std::memcpy(otaTx_.sha256, expectedSha256, sizeof(otaTx_.sha256));
+    otaTx_.flags |= OTA_TX_HAS_DIGEST;
+  }
+  otaTx_.flags |= OTA_TX_UNCOMMITTED;
+
+  // Persisted now: an OTA writer may switch the boot partition on its own
+  // (Update.end()), and the new image must know its prev slot even if the
+  // device resets before commitOtaTransaction().
+  persistEarly();
+  Store writer;
+  if (!writer.begin(opt_.nvsNamespace, false)) return false;
+  const bool stored = storeOtaTx_(writer);
+  writer.end();
+  if (!stored) return false;
+
+  otaTxActive_ = true;
+  log(LogLevel::Debug, "[CRG] OTA transaction started: %s -> %s\n", otaTx_.prevLabel, otaTx_.targetLabel);
+  return true;
+}
+
+void CrashRollbackGuard::abortOtaTransaction() {
+  if (!otaTxActive_) return;
+  otaTxActive_ = false;
+  persistEarly();
+  Store writer;
+  if (!writer.begin(opt_.nvsNamespace, false)) return;
+  writer.remove(K_OTA_TX);
+  writer.end();
+}
+
+bool CrashRollbackGuard::storeOtaTx_(Store& store) {
+  otaTx_.crc = crc32_(&otaTx_, offsetof(OtaTxRecord, crc));
+  // Single NVS entry: it is either fully there or not at all.
+  if (store.putBytes(K_OTA_TX, &otaTx_, sizeof(otaTx_)) != sizeof(otaTx_) || !store.commit()) {
+    log(LogLevel::Error, "[CRG] OTA transaction: failed to write record.\n");
+    return false;
+  }
+  return true;
+}
+
+bool CrashRollbackGuard::commitOtaTransaction() {
+  if (!otaTxActive_) return false;
+  otaTxActive_ = false;
+
+  const esp_partition_t* target = findAppPartitionByLabel_(otaTx_.targetLabel);
+  esp_app_desc_t desc;
+  bool verified = target && esp_ota_get_partition_description(target, &desc) == ESP_OK;
+  if (verified && (otaTx_.flags & OTA_TX_HAS_DIGEST)) {
+    uint8_t sha[sizeof(otaTx_.sha256)];
+    verified = esp_partition_get_sha256(target, sha) == ESP_OK &&
+               std::memcmp(sha, otaTx_.sha256, sizeof(sha)) == 0;
+  }
+  if (!verified) {
+    log(LogLevel::Error, "[CRG] OTA transaction: image in '%s' failed verification.\n", otaTx_.targetLabel);
+    // The OTA writer may already have activated the target; keep booting what runs now.
+    if (const esp_partition_t* running = esp_ota_get_running_partition()) {
+      esp_ota_set_boot_partition(running);
+    }
+  }
+
+  // A staged STAGE_OTA_TX left for the next boot would consume the record.
+  persistEarly();
+  Store writer;
+  if (!writer.begin(opt_.nvsNamespace, false)) return false;
+
+  if (!verified) {
+    writer.remove(K_OTA_TX);
+    writer.end();
+    return false;
+  }
+
+  otaTx_.flags &= static_cast<uint8_t>(~OTA_TX_UNCOMMITTED);
+  if (!storeOtaTx_(writer)) {
+    writer.end();
+    return false;
+  }
+
+  if (esp_ota_set_boot_partition(target) != ESP_OK) {
+    log(LogLevel::Error, "[CRG] OTA transaction: failed to set boot partition '%s'.\n", otaTx_.targetLabel);
+    writer.remove(K_OTA_TX);
+    writer.end();
+    return false;
+  }
+  writer.end();
+
+  log(LogLevel::Info, "[CRG] OTA transaction committed: %s -> %s\n", otaTx_.prevLabel, otaTx_.targetLabel);
+  return true;
+}
+
+CrashRollbackGuard::LabelStatus CrashRollbackGuard::loadOtaTx_(Store& store, OtaTxRecord& tx) const {
+  if (!store.isKey(K_OTA_TX)) return LabelStatus::Missing;
+  if (store.getBytes(K_OTA_TX, &tx, sizeof(tx)) != sizeof(tx) ||
+      tx.version != OTA_TX_VERSION ||
+      tx.crc != crc32_(&tx, offsetof(OtaTxRecord, crc))) {
+    return LabelStatus::Corrupted;
+  }
+  tx.prevLabel[sizeof(tx.prevLabel) - 1] = '\0';
+  tx.targetLabel[sizeof(tx.targetLabel) - 1] = '\0';
+  return LabelStatus::Ok;
+}
+
+bool CrashRollbackGuard::applyOtaTx_(Store& store, const char* runningLabel) {
+  OtaTxRecord tx;
+  const LabelStatus status = loadOtaTx_(store, tx);
+  if (status == LabelStatus::Missing) return false;
+
+  bool completed = false;
+  if (status == LabelStatus::Corrupted) {
+    log(LogLevel::Error, "[CRG] OTA transaction record corrupted. Clearing.\n");
+  } else if (runningLabel[0] != '\0' && strcmp(tx.targetLabel, runningLabel) == 0) {
+    // The record carries both the prev slot and the restart intent; apply the
+    // prev slot before dropping the record so a reset here only repeats it.
+    // An uncommitted record still names the prev slot: the OTA writer switched
+    // the boot partition and the device reset before the commit.
+    if (storeLabelWithCrc_(store, K_PREV_LABEL, K_PREV_CRC, tx.prevLabel)) {
+      resetRollbackCount_(store);
+    }
+    completed = true;
+    log(LogLevel::Info,
+        "[CRG] OTA transaction %s: %s -> %s\n",
+        (tx.flags & OTA_TX_UNCOMMITTED) ? "booted before commit" : "completed",
+        tx.prevLabel,
+        runningLabel);
+  } else {
+    log(LogLevel::Error,
+        "[CRG] OTA transaction target mismatch (target=%s running=%s).\n",
+        tx.targetLabel,
+        runningLabel);
+  }
+
+  store.remove(K_OTA_TX);
+  return completed;
+}
+
 void CrashRollbackGuard::markHealthyNow() {
+  markHealthy_(false);
+}
+
+void CrashRollbackGuard::markServicesUp() {
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  if (servicesUpMs_ != 0 || healthyMarked_) return;
+  const uint32_t elapsed = platform::millisNow() - stableStartMs_;
+  servicesUpMs_ = elapsed ? elapsed : 1;
+#endif
+}
+
+void CrashRollbackGuard::markHealthy_(bool fromTimer) {
   if (healthyMarked_) return;
+  // Crashes after the health mark say nothing about the validation window.
+  detail::rtcState.uptimeMs = 0;
+  // The reset below must win over the counters staged by decideEarly().
+  persistEarly();
   if (!prefs_.begin(opt_.nvsNamespace, false)) return;
 
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  // The sample is the readiness time from markServicesUp(), kept only once the
+  // boot has survived to validation. Neither mark's own time is a sample: the
+  // timer would echo the window back, an explicit mark ends it early.
+  if (opt_.adaptiveStableTime && servicesUpMs_ != 0) {
+    recordHealthySample_(prefs_, servicesUpMs_);
+  }
+#endif
+  (void)fromTimer;
+
   const uint32_t fails = readFailCounter_(prefs_);
   const uint8_t rbCnt  = readRollbackCount_(prefs_);
 #if CRG_FEATURE_PENDING_VERIFY_FIX
@@ -407,7 +1187,21 @@ void CrashRollbackGuard::markHealthyNow() {
   const bool needOtaMark = false;
 #endif
 
-  if (fails == 0 && rbCnt == 0 && !needOtaMark) {
+#if CRG_FEATURE_CRASH_SIGNATURE
+  SignatureRecord sigRec;
+  loadSignatureTable_(prefs_, sigRec);
+  bool hasSignatures = false;
+  for (uint8_t i = 0; i < CRG_SIGNATURE_SLOTS; ++i) {
+    hasSignatures = hasSignatures || sigRec.hits[i] != 0;
+  }
+  const bool tagImage = opt_.signatureRepeatLimit != 0 &&
+                        prefs_.getUInt(K_HEALTHY_IMAGE, 0) != currentImageTag_();
+#else
+  const bool hasSignatures = false;
+  const bool tagImage = false;
+#endif
+
+  if (fails == 0 && rbCnt == 0 && !needOtaMark && !hasSignatures && !tagImage) {
     prefs_.end();
     healthyMarked_ = true;
     log(LogLevel::Debug, "[CRG] markHealthyNow() skipped (already clean).\n");
@@ -416,6 +1210,17 @@ void CrashRollbackGuard::markHealthyNow() {
 
   resetFailCounter_(prefs_);
   resetRollbackCount_(prefs_);
+#if CRG_FEATURE_CRASH_SIGNATURE
+  if (hasSignatures) {
+    // The counts start over; the last counted dump stays known, it is still in flash.
+    std::memset(sigRec.sig, 0, sizeof(sigRec.sig));
+    std::memset(sigRec.hits, 0, sizeof(sigRec.hits));
+    storeSignatureTable_(prefs_, sigRec);
+  }
+  if (tagImage) {
+    prefs_.putUInt(K_HEALTHY_IMAGE, currentImageTag_());
+  }
+#endif
   prefs_.end();
 
 #if CRG_FEATURE_PENDING_VERIFY_FIX
@@ -435,11 +1240,81 @@ void CrashRollbackGuard::markHealthyNow() {
   log(LogLevel::Info, "[CRG] Marked healthy. fails reset.\n");
 }
 
+void CrashRollbackGuard::runPostBoot() {
+  persistEarly();
+  if (postBootTasks_ == 0) return;
+  const uint32_t startUs = platform::microsNow();
+  const uint8_t tasks = postBootTasks_;
+  postBootTasks_ = 0;
+
+#if CRG_FEATURE_FACTORY_FALLBACK
+  if ((tasks & PB_VALIDATE_FACTORY) && opt_.fallbackToFactory) {
+    if (!opt_.factoryLabel || !findAppPartitionByLabel_(opt_.factoryLabel)) {
+      log(LogLevel::Error,
+          "[CRG] factory fallback disabled: partition '%s' not found.\n",
+          opt_.factoryLabel ? opt_.factoryLabel : "<unset>");
+      opt_.fallbackToFactory = false;
+    }
+  }
+#endif
+
+  if (tasks & (PB_AUTOSAVE_PREV | PB_REPAIR_COUNTERS | PB_UPTIME_STATS)) {
+    Store writer;
+    if (!writer.begin(opt_.nvsNamespace, false)) {
+      log(LogLevel::Error, "[CRG] NVS open failed (post-boot)\n");
+      bootTimings_.postBootUs = platform::microsNow() - startUs;
+      return;
+    }
+
+    if (tasks & PB_REPAIR_COUNTERS) {
+      readFailCounter_(writer);
+      readRollbackCount_(writer);
+    }
+
+    if (tasks & PB_AUTOSAVE_PREV) {
+      char runningLabel[CRG_LABEL_BUFFER_SIZE];
+      char prev[CRG_LABEL_BUFFER_SIZE];
+      const LabelStatus status = loadLabelWithCrc_(writer, K_PREV_LABEL, K_PREV_CRC, prev, sizeof(prev));
+      if (status == LabelStatus::Missing && readRunningLabel_(runningLabel, sizeof(runningLabel))) {
+        if (storeLabelWithCrc_(writer, K_PREV_LABEL, K_PREV_CRC, runningLabel)) {
+          resetRollbackCount_(writer);
+          log(LogLevel::Debug, "[CRG] Auto-saved prev slot: %s\n", runningLabel);
+        }
+      } else if (status == LabelStatus::Corrupted) {
+        log(LogLevel::Error, "[CRG] Auto-saved prev slot corrupted. Clearing.\n");
+        writer.remove(K_PREV_LABEL);
+        writer.remove(K_PREV_CRC);
+      }
+    }
+
+#if CRG_FEATURE_ADAPTIVE_STABLE
+    if (tasks & PB_UPTIME_STATS) {
+      refreshUptimeStats_(writer);
+    }
+#endif
+
+    writer.end();
+  }
+
+  bootTimings_.postBootUs = platform::microsNow() - startUs;
+  log(LogLevel::Debug,
+      "[CRG] Post-boot done in %lu us (early stage %lu us).\n",
+      (unsigned long)bootTimings_.postBootUs,
+      (unsigned long)bootTimings_.earlyUs);
+}
+
 void CrashRollbackGuard::loopTick() {
+  runPostBoot();
 #if CRG_FEATURE_STABLE_TICK
   if (healthyMarked_ || opt_.stableTimeMs == 0) return;
-  if ((uint32_t)(millis() - stableStartMs_) >= opt_.stableTimeMs) {
-    markHealthyNow();
+  const uint32_t elapsed = (uint32_t)(platform::millisNow() - stableStartMs_);
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  if (opt_.adaptiveStableTime) {
+    detail::rtcState.uptimeMs = elapsed ? elapsed : 1; // 0 means "no sample"
+  }
+#endif
+  if (elapsed >= stableWindowMs()) {
+    markHealthy_(true);
   }
 #else
   // Feature disabled to save flash/RAM; keep method as a no-op.
@@ -447,8 +1322,17 @@ void CrashRollbackGuard::loopTick() {
 #endif
 }
 
+uint32_t CrashRollbackGuard::stableWindowMs() const {
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  if (opt_.adaptiveStableTime && adaptiveStableMs_ != 0) return adaptiveStableMs_;
+#endif
+  return opt_.stableTimeMs;
+}
+
 void CrashRollbackGuard::armControlledRestart() {
-  Preferences writer;
+  // A staged STAGE_CLEAR_PENDING replayed on the next boot would erase this intent.
+  persistEarly();
+  Store writer;
   if (!writer.begin(opt_.nvsNamespace, false)) return;
 
   char label[CRG_LABEL_BUFFER_SIZE];
@@ -463,7 +1347,7 @@ void CrashRollbackGuard::armControlledRestart() {
   writer.end();
 }
 
-Decision CrashRollbackGuard::attemptRollback_(Preferences& store, const char* why) {
+Decision CrashRollbackGuard::attemptRollback_(Store& store, const char* why) {
   char current[CRG_LABEL_BUFFER_SIZE];
   char prev[CRG_LABEL_BUFFER_SIZE];
   current[0] = '\0';
@@ -512,9 +1396,12 @@ Decision CrashRollbackGuard::attemptRollback_(Preferences& store, const char* wh
   }
 #endif
 
+  // The intent must be durable before the boot partition changes.
   storePendingAction_(store, PendingAction::RollbackPrev, prev);
+  store.commit();
   if (switchBootPartitionByLabel_(prev)) {
     bumpRollbackCount_(store);
+    store.commit();
     log(LogLevel::Error, "[CRG] Switch boot to '%s' and reboot.\n", prev);
     esp_restart(); // Does not return.
     return Decision::RollbackToPrev;
@@ -526,9 +1413,112 @@ Decision CrashRollbackGuard::attemptRollback_(Preferences& store, const char* wh
 }
 
 Decision CrashRollbackGuard::beginEarly() {
-  resetReason_ = esp_reset_reason();
+  const Decision d = decideEarly();
+  persistEarly();
+  return d;
+}
+
+Decision CrashRollbackGuard::decideEarly() {
+#if CRG_EARLY_BOOT_HOOK
+  // The decision for this boot was already taken before global constructors.
+  if (earlyHookRan_) return profile_.decision;
+#endif
+  const uint32_t startUs = platform::microsNow();
+  profile_ = BootProfile{};
+  profile_.decision = decideEarly_();
+  profile_.pendingVerify = pendingVerify_;
+  profile_.tier = recommendTier_();
+  bootTimings_.earlyUs = platform::microsNow() - startUs;
+
+  if (profile_.tier != BootTier::Normal) {
+    log(LogLevel::Info,
+        "[CRG] Boot tier %u (fails=%u/%u).\n",
+        static_cast<unsigned>(profile_.tier),
+        (unsigned)profile_.fails,
+        (unsigned)opt_.failLimit);
+  }
+  return profile_.decision;
+}
+
+Decision CrashRollbackGuard::beginEarly(BootProfile& profile) {
+  const Decision d = beginEarly();
+  profile = profile_;
+  return d;
+}
+
+BootTier CrashRollbackGuard::recommendTier_() const {
+  switch (profile_.decision) {
+    case Decision::SkippedNoPrev:
+    case Decision::SkippedSameSlot:
+    case Decision::FailedSwitch:
+      // Rollback was wanted but is impossible: keep the crash surface minimal.
+      return BootTier::Minimal;
+    default:
+      break;
+  }
+  if (profile_.fails == 0 || opt_.failLimit == 0) return BootTier::Normal;
+  if (profile_.fails + 1 >= opt_.failLimit) return BootTier::Minimal;
+  return BootTier::Reduced;
+}
+
+bool CrashRollbackGuard::registerService(const char* name, BootTier tier, ServiceStartFn start) {
+  if (!start || serviceCount_ >= CRG_MAX_SERVICES) {
+    log(LogLevel::Error, "[CRG] Cannot register service '%s'.\n", name ? name : "<unnamed>");
+    return false;
+  }
+  services_[serviceCount_++] = Service{name, tier, start};
+  return true;
+}
+
+bool CrashRollbackGuard::serviceAllowed(BootTier tier) const {
+  return static_cast<uint8_t>(tier) >= static_cast<uint8_t>(profile_.tier);
+}
+
+uint8_t CrashRollbackGuard::startServices() {
+  uint8_t started = 0;
+  for (uint8_t i = 0; i < serviceCount_; ++i) {
+    const Service& svc = services_[i];
+    if (!serviceAllowed(svc.tier)) {
+      log(LogLevel::Info,
+          "[CRG] Skipping service '%s' (boot tier %u).\n",
+          svc.name ? svc.name : "<unnamed>",
+          static_cast<unsigned>(profile_.tier));
+      continue;
+    }
+    svc.start();
+    ++started;
+  }
+  return started;
+}
+
+esp_reset_reason_t CrashRollbackGuard::readResetReason_() {
+  const esp_reset_reason_t reason = esp_reset_reason();
+#if CRG_EARLY_BOOT_HOOK
+  if (reason == ESP_RST_UNKNOWN) {
+    return decodeEarlyResetReason_();
+  }
+#endif
+  return reason;
+}
+
+Decision CrashRollbackGuard::decideEarly_() {
+  resetReason_ = readResetReason_();
   healthyMarked_ = false;
-  stableStartMs_ = millis();
+  stableStartMs_ = platform::millisNow();
+  uint8_t markedComponent = 0;
+  uint32_t markedUptimeMs = 0;
+  takeRtcState_(markedComponent, markedUptimeMs);
+  stage_ = claimStage_();
+  earlyDecided_ = true;
+  (void)markedComponent;
+  crashComponent_ = 0;
+  crashUptimeMs_ = 0;
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  servicesUpMs_ = 0;
+  if (opt_.adaptiveStableTime) {
+    postBootTasks_ |= PB_UPTIME_STATS;
+  }
+#endif
 
 #if CRG_FEATURE_PENDING_VERIFY_FIX
   pendingVerify_ = false;
@@ -550,21 +1540,51 @@ Decision CrashRollbackGuard::beginEarly() {
     return Decision::None;
   }
 
-  uint32_t fails = readFailCounter_(prefs_);
+  if (stage_->flags != 0) {
+    // The previous boot reset before persistEarly(). Finish its writes first so
+    // its crash stays counted and the pending action it consumed is not replayed.
+    log(LogLevel::Info, "[CRG] Flushing state staged by the previous boot.\n");
+    flushStage_(prefs_);
+  }
+
+  // Mirror repair is deferred: a suspicious boot rewrites the counter anyway,
+  // everything else is handled by runPostBoot().
+  bool failsCorrupted = false;
+  uint32_t& fails = profile_.fails;
+  fails = readFailCounter_(prefs_, false, &failsCorrupted);
+  if (failsCorrupted) {
+    postBootTasks_ |= PB_REPAIR_COUNTERS;
+  }
   char runningLabel[CRG_LABEL_BUFFER_SIZE];
   readRunningLabel_(runningLabel, sizeof(runningLabel));
 
+  // From here on nothing is written: changes go to stage_ and reach NVS
+  // in persistEarly(), or right before a rollback below.
   bool pendingBoot = false;
+  OtaTxRecord tx;
+  const LabelStatus txStatus = loadOtaTx_(prefs_, tx);
+  if (txStatus != LabelStatus::Missing) {
+    stage_->flags |= STAGE_OTA_TX; // applied or dropped by flushStage_()
+    // Only a committed record carries the restart intent; an uncommitted one
+    // leaves this reset to be classified as usual.
+    if (txStatus == LabelStatus::Ok && !(tx.flags & OTA_TX_UNCOMMITTED) &&
+        runningLabel[0] != '\0' && strcmp(tx.targetLabel, runningLabel) == 0) {
+      pendingBoot = true;
+      if (fails != 0) stageFails_(0);
+      fails = 0;
+    }
+  }
+
   char pendingLabel[CRG_LABEL_BUFFER_SIZE];
   const PendingAction pendingAction = readPendingAction_(prefs_, pendingLabel, sizeof(pendingLabel));
   if (pendingAction != PendingAction::None) {
     const bool labelPresent = (pendingLabel[0] != '\0');
     const bool labelMatches = labelPresent && runningLabel[0] != '\0' && strcmp(pendingLabel, runningLabel) == 0;
 
+    stage_->flags |= STAGE_CLEAR_PENDING;
     if (pendingAction == PendingAction::ControlledRestart) {
       pendingBoot = true;
-      clearPendingAction_(prefs_);
-      resetFailCounter_(prefs_);
+      if (fails != 0) stageFails_(0);
       fails = 0;
       if (labelPresent && !labelMatches) {
         log(LogLevel::Error,
@@ -580,8 +1600,7 @@ Decision CrashRollbackGuard::beginEarly() {
       }
     } else if (labelMatches) {
       pendingBoot = true;
-      clearPendingAction_(prefs_);
-      resetFailCounter_(prefs_);
+      if (fails != 0) stageFails_(0);
       fails = 0;
       log(LogLevel::Info,
           "[CRG] Pending action %u completed on %s.\n",
@@ -593,33 +1612,32 @@ Decision CrashRollbackGuard::beginEarly() {
           static_cast<unsigned>(pendingAction),
           pendingLabel,
           runningLabel);
-      clearPendingAction_(prefs_);
     }
   }
 
   if (opt_.autoSavePrevSlot) {
-    char prev[CRG_LABEL_BUFFER_SIZE];
-    const LabelStatus status = loadLabelWithCrc_(prefs_, K_PREV_LABEL, K_PREV_CRC, prev, sizeof(prev));
-    if (status == LabelStatus::Missing && runningLabel[0] != '\0') {
-      if (storeLabelWithCrc_(prefs_, K_PREV_LABEL, K_PREV_CRC, runningLabel)) {
-        resetRollbackCount_(prefs_);
-        log(LogLevel::Debug, "[CRG] Auto-saved prev slot: %s\n", runningLabel);
-      }
-    } else if (status == LabelStatus::Corrupted) {
-      log(LogLevel::Error, "[CRG] Auto-saved prev slot corrupted. Clearing.\n");
-      prefs_.remove(K_PREV_LABEL);
-      prefs_.remove(K_PREV_CRC);
-    }
+    // Auto-saving the running slot never helps the rollback decision on this
+    // boot (prev == current is skipped anyway), so it is done post-boot.
+    postBootTasks_ |= PB_AUTOSAVE_PREV;
   }
 
   const bool suspicious = !pendingBoot && isSuspicious(resetReason_);
+  profile_.suspicious = suspicious;
 
   if (!suspicious) {
-    if (fails != 0) writeFailCounter_(prefs_, 0);
+    if (fails != 0) stageFails_(0);
+    fails = 0;
     prefs_.end();
     return Decision::None;
   }
-  
+
+  crashUptimeMs_ = markedUptimeMs;
+
+#if CRG_FEATURE_COMPONENTS
+  crashComponent_ = markedComponent;
+  const bool componentAbsorbed = crashComponent_ != 0 && componentCrashAbsorbed_(prefs_, crashComponent_);
+#endif
+
   if (opt_.failLimit == 0) {
     log(LogLevel::Debug, "[CRG] failLimit=0, watchdog disabled. Ignoring crash.\n");
     prefs_.end();
@@ -628,29 +1646,41 @@ Decision CrashRollbackGuard::beginEarly() {
 
 #if CRG_FEATURE_PENDING_VERIFY_FIX
   if (!pendingBoot && runningImgState_ == ESP_OTA_IMG_INVALID) {
+    flushStage_(prefs_);
     const Decision d = attemptRollback_(prefs_, "Running image invalid");
     prefs_.end();
     return d;
   }
 #endif
 
+#if CRG_FEATURE_CRASH_SIGNATURE
+  // The same deterministic crash on an unproven image will not go away by itself:
+  // skip the remaining failLimit reboot cycles.
+  if (!pendingBoot && crashSignatureRepeated_(prefs_)) {
+    flushStage_(prefs_);
+    const Decision d = guardedRollback_(prefs_, "Repeated crash signature");
+    prefs_.end();
+    return d;
+  }
+#endif
+
+#if CRG_FEATURE_COMPONENTS
+  if (componentAbsorbed) {
+    // The app can disable the component instead of burning a rollback cycle.
+    prefs_.end();
+    return Decision::None;
+  }
+#endif
+
   if (fails < opt_.failLimit) {
     ++fails;
-    writeFailCounter_(prefs_, fails);
+    stageFails_(fails);
   }
 
   if (fails >= opt_.failLimit && opt_.failLimit > 0) {
-    if (opt_.maxRollbackAttempts > 0) {
-      const uint8_t guard = readRollbackCount_(prefs_);
-      if (guard >= opt_.maxRollbackAttempts) {
-        log(LogLevel::Error, "[CRG] Rollback guard hit (%u >= %u).\n", guard, opt_.maxRollbackAttempts);
-        const Decision guarded = tryFactoryFallback_(prefs_, Decision::SkippedNoPrev, "Rollback guard active");
-        prefs_.end();
-        return guarded;
-      }
-    }
-
-    const Decision d = attemptRollback_(prefs_, "Crash-loop limit reached");
+    // Rollback restarts right away: nothing may stay staged.
+    flushStage_(prefs_);
+    const Decision d = guardedRollback_(prefs_, "Crash-loop limit reached");
     prefs_.end();
     return d;
   }
@@ -659,7 +1689,19 @@ Decision CrashRollbackGuard::beginEarly() {
   return Decision::None;
 }
 
-Decision CrashRollbackGuard::tryFactoryFallback_(Preferences& store, Decision failureDecision, const char* cause) {
+Decision CrashRollbackGuard::guardedRollback_(Store& store, const char* why) {
+  // Caps slot ping-pong: every rollback path counts against maxRollbackAttempts.
+  if (opt_.maxRollbackAttempts > 0) {
+    const uint8_t guard = readRollbackCount_(store);
+    if (guard >= opt_.maxRollbackAttempts) {
+      log(LogLevel::Error, "[CRG] Rollback guard hit (%u >= %u).\n", guard, opt_.maxRollbackAttempts);
+      return tryFactoryFallback_(store, Decision::SkippedNoPrev, "Rollback guard active");
+    }
+  }
+  return attemptRollback_(store, why);
+}
+
+Decision CrashRollbackGuard::tryFactoryFallback_(Store& store, Decision failureDecision, const char* cause) {
 #if !CRG_FEATURE_FACTORY_FALLBACK
   (void)cause;
   return failureDecision;
@@ -668,12 +1710,23 @@ Decision CrashRollbackGuard::tryFactoryFallback_(Preferences& store, Decision fa
     return failureDecision;
   }
 
+  // runPostBoot() may not have validated the label yet on this boot.
+  if (!findAppPartitionByLabel_(opt_.factoryLabel)) {
+    log(LogLevel::Error,
+        "[CRG] factory fallback disabled: partition '%s' not found.\n",
+        opt_.factoryLabel);
+    opt_.fallbackToFactory = false;
+    postBootTasks_ &= static_cast<uint8_t>(~PB_VALIDATE_FACTORY);
+    return failureDecision;
+  }
+
   log(LogLevel::Error,
       "[CRG] %s -> fallback to factory '%s'.\n",
       cause ? cause : "Fallback",
       opt_.factoryLabel);
 
   storePendingAction_(store, PendingAction::RollbackFactory, opt_.factoryLabel);
+  store.commit();
   if (switchBootPartitionByLabel_(opt_.factoryLabel)) {
     esp_restart();
     return Decision::RollbackToFactory;
@@ -686,3 +1739,77 @@ Decision CrashRollbackGuard::tryFactoryFallback_(Preferences& store, Decision fa
 }
 
 } // namespace crg
+
+#if CRG_EARLY_BOOT_HOOK
+namespace crg {
+
+__attribute__((weak)) void configureEarlyBoot(Options& opt) {
+  (void)opt;
+}
+
+namespace {
+// Constructed right before the hook below; no heap, no dependency on other globals.
+CrashRollbackGuard g_earlyGuard __attribute__((init_priority(CRG_EARLY_BOOT_PRIORITY)));
+} // namespace
+
+CrashRollbackGuard& earlyGuard() { return g_earlyGuard; }
+
+esp_reset_reason_t CrashRollbackGuard::decodeEarlyResetReason_() {
+  // esp_reset_reason() is filled by a global constructor of its own that may
+  // not have run yet. Decode the ROM reason plus the hint left by
+  // esp_restart()/panic handlers, the same inputs it uses.
+  const esp_reset_reason_t hint = esp_reset_reason_get_hint();
+  switch (esp_rom_get_reset_reason(0)) {
+    case RESET_REASON_CHIP_POWER_ON:
+      return ESP_RST_POWERON;
+    case RESET_REASON_CORE_DEEP_SLEEP:
+      return ESP_RST_DEEPSLEEP;
+    case RESET_REASON_SYS_BROWN_OUT:
+      return ESP_RST_BROWNOUT;
+    case RESET_REASON_CORE_SW:
+    case RESET_REASON_CPU0_SW:
+      return (hint != ESP_RST_UNKNOWN) ? hint : ESP_RST_SW;
+    // Timer group watchdogs: the panic handler leaves a hint for the
+    // interrupt WDT and for panics; a bare reset is the task WDT.
+    case RESET_REASON_CORE_MWDT0:
+    case RESET_REASON_CORE_MWDT1:
+    case RESET_REASON_CPU0_MWDT0:
+#if !CONFIG_IDF_TARGET_ESP32
+    case RESET_REASON_CPU0_MWDT1:
+#endif
+      if (hint == ESP_RST_PANIC || hint == ESP_RST_INT_WDT || hint == ESP_RST_TASK_WDT) {
+        return hint;
+      }
+      return ESP_RST_TASK_WDT;
+    case RESET_REASON_CORE_RTC_WDT:
+    case RESET_REASON_CPU0_RTC_WDT:
+    case RESET_REASON_SYS_RTC_WDT:
+      return ESP_RST_WDT;
+    default:
+      return hint; // anything else stays suspicious by default
+  }
+}
+
+namespace detail {
+
+void runEarlyBootHook() {
+  Options opt;
+  opt.logLevel = LogLevel::None; // Serial is not constructed yet
+  configureEarlyBoot(opt);
+  g_earlyGuard.setOptions(opt);
+
+  // The Arduino core initializes NVS later in app_main(); a second
+  // nvs_flash_init() there is a no-op. On failure leave the decision to setup().
+  if (nvs_flash_init() != ESP_OK) return;
+
+  g_earlyGuard.beginEarly();
+  g_earlyGuard.earlyHookRan_ = true;
+}
+
+} // namespace detail
+} // namespace crg
+
+__attribute__((constructor(CRG_EARLY_BOOT_PRIORITY + 1))) static void crgEarlyBootHook() {
+  crg::detail::runEarlyBootHook();
+}
+#endif
@@ -1,12 +1,19 @@
 #pragma once
 
-#include <Arduino.h>
-#include <Preferences.h>
+#include "CrgPlatform.h"
 
+#include "esp_attr.h"
 #include "esp_system.h"
 #include "esp_partition.h"
 #include "esp_ota_ops.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "CrgIntegrity.h"
+#include "CrgStore.h"
+
 #ifndef ESP_PARTITION_LABEL_MAX_LEN
   // IDF 4.x+ defines this (16). Arduino cores may miss it, so guard here.
   #define ESP_PARTITION_LABEL_MAX_LEN 16
@@ -65,6 +72,78 @@
   #define CRG_NAMESPACE_MAX_LEN 15
 #endif
 
+#ifndef CRG_FEATURE_COMPONENTS
+  // 0 — убрать учёт падений по компонентам (RTC-маркеры enterComponent()/exitComponent()).
+  #define CRG_FEATURE_COMPONENTS 1
+#endif
+
+#ifndef CRG_MAX_COMPONENTS
+  // Сколько компонентов отслеживать: id 1..CRG_MAX_COMPONENTS (0 = "вне компонента").
+  #define CRG_MAX_COMPONENTS 8
+#endif
+
+#ifndef CRG_MAX_SERVICES
+  // Размер реестра сервисов для профилей загрузки (registerService()).
+  #define CRG_MAX_SERVICES 12
+#endif
+
+#ifndef CRG_EARLY_BOOT_HOOK
+  // 1 — выполнить beginEarly() статического гварда earlyGuard() до глобальных
+  // конструкторов приложения и setup(). Настройка — через crg::configureEarlyBoot().
+  #define CRG_EARLY_BOOT_HOOK 0
+#endif
+
+#ifndef CRG_EARLY_BOOT_PRIORITY
+  // Приоритет конструктора хука (101 — самый ранний из доступных приложению).
+  #define CRG_EARLY_BOOT_PRIORITY 101
+#endif
+
+#ifndef CRG_EARLY_STAGE_SLOTS
+  // Сколько гвардов с разными nvsNamespace могут одновременно держать
+  // незаписанный stage в RTC-памяти.
+  #define CRG_EARLY_STAGE_SLOTS 2
+#endif
+
+#ifndef CRG_FEATURE_ASYNC_PERSIST
+  // 0 — убрать persistEarlyAsync() (фоновую задачу со статическим стеком).
+  #define CRG_FEATURE_ASYNC_PERSIST 1
+#endif
+
+#ifndef CRG_PERSIST_TASK_STACK
+  // Стек задачи persistEarlyAsync() в байтах (выделяется статически).
+  #define CRG_PERSIST_TASK_STACK 3072
+#endif
+
+#ifndef CRG_FEATURE_ADAPTIVE_STABLE
+  // 0 — убрать адаптивное окно стабильности и статистику time-to-healthy.
+  #define CRG_FEATURE_ADAPTIVE_STABLE 1
+#endif
+
+#ifndef CRG_STATS_SAMPLES
+  // Сколько последних значений time-to-healthy хранить (uptime-before-crash — вдвое меньше).
+  #define CRG_STATS_SAMPLES 16
+#endif
+
+#ifndef CRG_STATS_MIN_SAMPLES
+  // Минимум измерений, после которого окно начинает адаптироваться.
+  #define CRG_STATS_MIN_SAMPLES 4
+#endif
+
+#ifndef CRG_FEATURE_CRASH_SIGNATURE
+  // 0 — не читать core dump summary и не вести таблицу сигнатур падений.
+  #define CRG_FEATURE_CRASH_SIGNATURE 1
+#endif
+
+#ifndef CRG_SIGNATURE_SLOTS
+  // Размер таблицы последних сигнатур падений.
+  #define CRG_SIGNATURE_SLOTS 4
+#endif
+
+#ifndef CRG_SIGNATURE_BT_DEPTH
+  // Сколько кадров backtrace входит в сигнатуру.
+  #define CRG_SIGNATURE_BT_DEPTH 8
+#endif
+
 namespace crg {
 
 enum class LogLevel : uint8_t {
@@ -74,6 +153,14 @@ enum class LogLevel : uint8_t {
   Debug = 3
 };
 
+// Приёмник строк лога (уже с префиксом "[CRG]" и переводом строки).
+using LogSink = void (*)(const char* line, void* arg);
+
+#if CRG_ARDUINO
+// LogSink для Print: opt.logSink = crg::printLogSink; opt.logArg = &Serial1;
+inline void printLogSink(const char* line, void* arg) { static_cast<Print*>(arg)->print(line); }
+#endif
+
 struct Options {
   const char* nvsNamespace      = CRG_NAMESPACE;
   uint32_t    failLimit         = CRG_FAIL_LIMIT;
@@ -84,7 +171,10 @@ struct Options {
   bool        autoSavePrevSlot  = (CRG_AUTOSAVE_PREV_SLOT != 0);
 
   LogLevel    logLevel          = (CRG_LOG_ENABLED ? LogLevel::Info : LogLevel::None);
-  Print*      logOutput         = &Serial;
+  // nullptr — вывод по умолчанию: Serial с Arduino, иначе esp_log с тегом "CRG".
+  // Раскладка Options не зависит от CRG_ARDUINO; выключить лог — logLevel = None.
+  LogSink     logSink           = nullptr;
+  void*       logArg            = nullptr;
 
   // Если true — при достижении failLimit будет пытаться fallback на factory,
   // если prev-slot не задан или недоступен.
@@ -99,8 +189,98 @@ struct Options {
   // Политика reset reason по умолчанию.
   bool        swResetCountsAsCrash      = false; // ESP_RST_SW
   bool        brownoutCountsAsCrash     = false; // ESP_RST_BROWNOUT
+
+  // Сколько падений внутри одного компонента прощается глобальному счётчику fails.
+  // Пока лимит не выбран, приложение должно отключить компонент (componentDisabled()),
+  // а не ждать полного rollback. 0 = только статистика, fails считается как обычно.
+  uint8_t     componentFailLimit        = 0;
+
+  // Сколько раз одна и та же сигнатура падения (PC + backtrace из core dump)
+  // должна повториться на образе, который ещё ни разу не был отмечен здоровым,
+  // чтобы откатиться сразу, не дожидаясь failLimit. 0 = выключено.
+  uint8_t     signatureRepeatLimit      = 0;
+
+  // Адаптивное окно стабильности для loopTick(): вместо фиксированного stableTimeMs
+  // берётся перцентиль времени до markServicesUp() плюс запас, но не меньше
+  // самого позднего падения текущего образа до health-mark. Результат зажат в
+  // [stableTimeMinMs, stableTimeMaxMs]; пока измерений мало — stableTimeMs.
+  bool        adaptiveStableTime        = false;
+  uint32_t    stableTimeMinMs           = 5000;
+  uint32_t    stableTimeMaxMs           = 600000;
+  uint32_t    stableTimeMarginMs        = 5000;
+  uint8_t     stableTimePercentile      = 99;
 };
 
+namespace detail {
+#if CRG_EARLY_BOOT_HOOK
+void runEarlyBootHook();
+#endif
+
+// Результат decideEarly(), ещё не записанный в NVS. Значения абсолютные,
+// поэтому повторная запись (reset посреди persistEarly()) ничего не портит.
+struct EarlyStage {
+  uint32_t owner;          // crc32 от nvsNamespace владельца; 0 = слот свободен
+  uint8_t  flags;          // что записать; 0 = всё уже в NVS
+  uint8_t  component;      // компонент и его новый счётчик падений
+  uint8_t  componentCount;
+  uint8_t  signatureHits;  // новое число повторов signature
+  uint32_t fails;          // новое значение fail counter
+  uint32_t signature;
+  uint32_t dumpId;         // core dump, уже учтённый в signature
+};
+
+// Записи гварда в хранилище. crc считается по всем полям до crc.
+// Всё, что нужно следующей загрузке после OTA, в одной записи.
+struct OtaTxRecord {
+  uint8_t  version;
+  uint8_t  flags;
+  uint8_t  reserved[2];
+  char     prevLabel[CRG_LABEL_BUFFER_SIZE];
+  char     targetLabel[CRG_LABEL_BUFFER_SIZE];
+  uint8_t  sha256[32];
+  uint32_t crc;
+};
+
+#if CRG_FEATURE_ADAPTIVE_STABLE
+// Время в десятых долях секунды (до ~109 минут).
+struct UptimeStatsRecord {
+  uint32_t imageTag;
+  uint16_t healthyDs[CRG_STATS_SAMPLES];
+  uint16_t crashDs[CRG_STATS_SAMPLES / 2];
+  uint8_t  healthyCount;
+  uint8_t  healthyHead;
+  uint8_t  crashCount;
+  uint8_t  crashHead;
+  uint32_t crc;
+};
+#endif
+
+#if CRG_FEATURE_CRASH_SIGNATURE
+struct SignatureRecord {
+  uint32_t sig[CRG_SIGNATURE_SLOTS];
+  uint8_t  hits[CRG_SIGNATURE_SLOTS];
+  uint32_t lastDump; // dumpId последнего учтённого core dump
+  uint32_t crc;
+};
+#endif
+
+#if CRG_FEATURE_COMPONENTS
+struct ComponentRecord {
+  uint8_t  fails[CRG_MAX_COMPONENTS];
+  uint32_t crc;
+};
+#endif
+
+// Живёт в RTC-памяти: переживает panic/WDT/software reset, но не power-on.
+struct RtcState {
+  uint32_t          magic;
+  volatile uint8_t  component; // активный компонент (enterComponent())
+  volatile uint32_t uptimeMs;  // последний millis() из loopTick() до health-mark
+  EarlyStage        stage[CRG_EARLY_STAGE_SLOTS]; // незаписанные изменения decideEarly(), по слоту на namespace
+};
+extern RTC_NOINIT_ATTR RtcState rtcState;
+} // namespace detail
+
 enum class Decision : uint8_t {
   None,
   RollbackToPrev,
@@ -110,9 +290,50 @@ enum class Decision : uint8_t {
   FailedSwitch
 };
 
+// Рекомендуемый объём загрузки. Пока fails растёт, устройству выгоднее
+// грузиться быстро и минимально, чтобы быстрее дойти до решения о rollback.
+enum class BootTier : uint8_t {
+  Normal  = 0, // всё как обычно
+  Reduced = 1, // были падения: пропустить необязательные сервисы
+  Minimal = 2  // следующее падение = rollback (или rollback невозможен)
+};
+
+// Расширенный результат beginEarly()
+struct BootProfile {
+  Decision decision      = Decision::None;
+  BootTier tier          = BootTier::Normal;
+  uint32_t fails         = 0;     // fail counter после этой загрузки
+  bool     suspicious    = false; // reset посчитан подозрительным
+  bool     pendingVerify = false; // образ ждёт markHealthyNow()
+};
+
+using ServiceStartFn = void (*)();
+
 // Пользовательский фильтр reset reason
 using ResetReasonPredicate = bool (*)(esp_reset_reason_t);
 
+#if CRG_FEATURE_CRASH_SIGNATURE
+// Выжимка из core dump, из которой строится сигнатура падения.
+struct CrashSummary {
+  uint32_t pc = 0;
+  uint32_t backtrace[CRG_SIGNATURE_BT_DEPTH] = {};
+  uint8_t  depth = 0;
+  uint32_t dumpId = 0; // идентичность самого дампа (0 = неизвестна)
+};
+
+// Источник выжимки: по умолчанию esp_core_dump_get_summary(), дамп остаётся во
+// flash. Возвращает false, если дампа нет. Уже учтённый дамп гвард узнаёт по
+// dumpId; провайдер с dumpId = 0 должен отдавать каждый дамп только один раз.
+using CrashSummaryProvider = bool (*)(CrashSummary& out);
+#endif
+
+// Длительность стадий загрузки в микросекундах (0 — стадия ещё не выполнялась).
+struct BootTimings {
+  uint32_t earlyUs    = 0; // decideEarly(): решение "rollback или продолжаем"
+  uint32_t persistUs  = 0; // persistEarly(): запись счётчиков этой загрузки
+  uint32_t postBootUs = 0; // runPostBoot(): отложенные проверки и ремонт
+};
+
 class CrashRollbackGuard {
 public:
   CrashRollbackGuard();
@@ -124,15 +345,69 @@ public:
   // Если хочешь своё правило "подозрительности" reset reason
   void setSuspiciousResetPredicate(ResetReasonPredicate pred);
 
-  // Вызывать рано в setup()
+  // Подменить функцию целостности записей (по умолчанию integrity::crc32).
+  // Записи, сохранённые другой функцией, будут считаться повреждёнными и очищены.
+  void setIntegrityFunction(IntegrityFn fn);
+
+#if CRG_FEATURE_CRASH_SIGNATURE
+  // Подменить источник core dump summary (nullptr = отключить сигнатуры)
+  void setCrashSummaryProvider(CrashSummaryProvider provider);
+  // Сигнатура последнего подозрительного reset (0 = не было/недоступна)
+  uint32_t lastCrashSignature() const { return crashSignature_; }
+#endif
+
+  // Вызывать рано в setup(): decideEarly() + persistEarly().
   // Возвращает решение (например, выполнялся rollback или нет)
   Decision beginEarly();
+  // То же, плюс рекомендуемый BootTier и состояние счётчиков
+  Decision beginEarly(BootProfile& profile);
+  const BootProfile& bootProfile() const { return profile_; }
+
+  // Раздельный beginEarly(). decideEarly() только читает NVS и возвращает решение,
+  // а изменения (fails, pending action, OTA-транзакция, компонент, сигнатура) держит
+  // в RTC-памяти; пишет сразу только перед rollback. persistEarly() сбрасывает их в
+  // NVS, повторный вызов — no-op. Порядок:
+  //  - если reset случится до persistEarly(), следующая загрузка сначала допишет
+  //    изменения из RTC-памяти и только потом посчитает свой reset;
+  //  - markHealthyNow(), runPostBoot() и все методы, пишущие в NVS, сначала
+  //    вызывают persistEarly();
+  //  - power-on стирает RTC-память, но и сам не считается падением.
+  Decision decideEarly();
+  bool persistEarly();
+  bool earlyPersistPending() const;
+#if CRG_FEATURE_ASYNC_PERSIST
+  // persistEarly() в отдельной задаче со статическим стеком (одна на загрузку),
+  // чтобы запись шла параллельно со стартом WiFi и периферии.
+  bool persistEarlyAsync(UBaseType_t priority = 1, BaseType_t core = tskNO_AFFINITY);
+#endif
+
+  // Реестр сервисов: tier — минимальный профиль, в котором сервис ещё запускается
+  // (Minimal = обязательный, Normal = только при полной загрузке). name не копируется.
+  bool registerService(const char* name, BootTier tier, ServiceStartFn start);
+  // Запускать ли сервис с таким tier в текущем профиле
+  bool serviceAllowed(BootTier tier) const;
+  // Запустить разрешённые сервисы в порядке регистрации, вернуть их количество
+  uint8_t startServices();
+
+  // Отложенная работа, не нужная для решения о rollback: проверка factory,
+  // autoSavePrevSlot, ремонт зеркал счётчиков. Вызывается из loopTick(),
+  // но можно вызвать и самому (например, из отдельной задачи после старта WiFi).
+  void runPostBoot();
+  bool postBootPending() const { return postBootTasks_ != 0; }
+  const BootTimings& bootTimings() const { return bootTimings_; }
 
   // Вызвать когда система "точно жива" (после WiFi/MQTT/Web)
   void markHealthyNow();
 
+  // Сервисы поднялись, но образ ещё не подтверждён: только запоминает время для
+  // adaptiveStableTime. Подтверждает образ loopTick() по истечении stableWindowMs();
+  // замер попадает в статистику, только если загрузка дожила до подтверждения.
+  void markServicesUp();
+
   // Авто-сброс по времени "стабильной" работы: вызови в loop()
   void loopTick();
+  // Текущее окно стабильности для loopTick() (stableTimeMs или адаптивное)
+  uint32_t stableWindowMs() const;
 
   // Пометить, что следующий перезапуск через esp_restart()/ESP.restart() ожидаем и не считаем фейлом.
   void armControlledRestart();
@@ -142,30 +417,98 @@ public:
 
   // Получить сохранённый prev slot label
   bool getPreviousSlot(char* out, size_t len) const;
+#if CRG_ARDUINO
   String getPreviousSlot() const;
+#endif
 
   // Сбросить prev slot (если нужно)
   void clearPreviousSlot();
 
+  // Атомарная OTA-транзакция вместо saveCurrentAsPreviousSlot() + armControlledRestart().
+  // begin пишет одну запись в NVS: текущий слот, целевой раздел (nullptr = следующий
+  // OTA-слот) и ожидаемый SHA-256 образа (как esp_partition_get_sha256(), nullptr = не
+  // проверять), ещё без намерения перезапуска. Если writer сам переключит boot
+  // (Update.end()) и reset случится до commit, новый образ всё равно знает prev.
+  // commit проверяет образ, взводит запись и переключает boot; при неудачной
+  // проверке boot-раздел возвращается на текущий слот, запись удаляется.
+  bool beginOtaTransaction(const esp_partition_t* target = nullptr, const uint8_t* expectedSha256 = nullptr);
+  bool commitOtaTransaction();
+  void abortOtaTransaction();
+  bool otaTransactionActive() const { return otaTxActive_; }
+
   // Получить текущий running slot label
   static bool getRunningLabel(char* out, size_t len);
+#if CRG_ARDUINO
   static String getRunningLabel();
+#endif
+
+#if CRG_FEATURE_COMPONENTS
+  // Маркеры компонентов: одна запись в RTC-память, можно звать из горячих путей.
+  static void enterComponent(uint8_t id) { detail::rtcState.component = id; }
+  static void exitComponent() { detail::rtcState.component = 0; }
+
+  // Счётчик падений компонента (общая запись в NVS для всех компонентов)
+  uint8_t componentFailCount(uint8_t id) const;
+  // true, если компонент исчерпал componentFailLimit и его стоит не запускать
+  bool componentDisabled(uint8_t id) const;
+  // Сбросить счётчик компонента (0 = все компоненты)
+  void clearComponentFailures(uint8_t id = 0);
+  // Компонент, в котором случился последний подозрительный reset (0 = нет)
+  uint8_t lastCrashComponent() const { return crashComponent_; }
+#endif
 
   // Полезные данные
   esp_reset_reason_t lastResetReason() const;
   uint32_t failCount() const;
   bool pendingVerifyState() const { return pendingVerify_; }
-  Print* logOutput() const { return opt_.logOutput; }
 
 private:
+#if CRG_EARLY_BOOT_HOOK
+  friend void detail::runEarlyBootHook();
+  bool earlyHookRan_ = false;
+  static esp_reset_reason_t decodeEarlyResetReason_();
+#endif
+
   Options opt_ = Options{};
-  Preferences prefs_;
+  Store prefs_;
+  bool earlyDecided_ = false; // stage_ принадлежит этой загрузке
+  detail::EarlyStage* stage_ = nullptr; // слот в rtcState.stage или localStage_
+  detail::EarlyStage localStage_{};     // все RTC-слоты заняты другими гвардами
+#if CRG_FEATURE_ASYNC_PERSIST
+  SemaphoreHandle_t persistMutex_ = nullptr; // создаётся вместе с фоновой задачей
+  StaticSemaphore_t persistMutexBuf_;
+#endif
   ResetReasonPredicate suspiciousPred_ = nullptr;
+  IntegrityFn integrityFn_ = &integrity::crc32;
+#if CRG_FEATURE_CRASH_SIGNATURE
+  CrashSummaryProvider crashSummaryProvider_ = nullptr;
+  uint32_t crashSignature_ = 0;
+#endif
 
   bool healthyMarked_ = false;
   esp_reset_reason_t resetReason_ = ESP_RST_UNKNOWN;
   bool pendingVerify_ = false;
   uint32_t stableStartMs_ = 0;
+  uint8_t postBootTasks_ = 0;
+  uint8_t crashComponent_ = 0;
+  uint32_t crashUptimeMs_ = 0;
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  uint32_t adaptiveStableMs_ = 0; // 0 = статистики пока мало
+  uint32_t servicesUpMs_ = 0;     // время от decideEarly() до markServicesUp(), 0 = не было
+#endif
+#if CRG_FEATURE_ADAPTIVE_STABLE || CRG_FEATURE_CRASH_SIGNATURE
+  uint32_t imageTag_ = 0; // crc32 ELF SHA-256 запущенного образа
+#endif
+  BootProfile profile_{};
+
+  struct Service {
+    const char*    name;
+    BootTier       tier;
+    ServiceStartFn start;
+  };
+  Service services_[CRG_MAX_SERVICES] = {};
+  uint8_t serviceCount_ = 0;
+  BootTimings bootTimings_{};
 
 #if CRG_FEATURE_PENDING_VERIFY_FIX
   esp_ota_img_states_t runningImgState_ = ESP_OTA_IMG_UNDEFINED;
@@ -184,6 +527,44 @@ private:
   static constexpr const char* K_PENDING_ACT = "pendAct";
   static constexpr const char* K_PENDING_LABEL = "pendLbl";
   static constexpr const char* K_PENDING_CRC = "pendCrc";
+  static constexpr const char* K_COMP_FAILS = "compFail";
+  static constexpr const char* K_CRASH_SIG  = "crashSig";
+  static constexpr const char* K_UPTIME_STATS = "upStats";
+  static constexpr const char* K_OTA_TX     = "otaTx";
+  static constexpr const char* K_HEALTHY_IMAGE = "okImage"; // imageTag последнего здорового образа
+
+  static constexpr uint32_t RTC_MAGIC = 0x43524734u; // "CRG4", меняется вместе с RtcState
+
+  using OtaTxRecord = detail::OtaTxRecord;
+  static constexpr uint8_t OTA_TX_VERSION    = 1;
+  static constexpr uint8_t OTA_TX_HAS_DIGEST = 0x01;
+  static constexpr uint8_t OTA_TX_UNCOMMITTED = 0x02; // begin без commit: только prev, без restart intent
+
+  OtaTxRecord otaTx_{};
+  bool otaTxActive_ = false;
+
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  using UptimeStatsRecord = detail::UptimeStatsRecord;
+#endif
+#if CRG_FEATURE_CRASH_SIGNATURE
+  using SignatureRecord = detail::SignatureRecord;
+#endif
+#if CRG_FEATURE_COMPONENTS
+  using ComponentRecord = detail::ComponentRecord;
+#endif
+
+  // Задачи для runPostBoot()
+  static constexpr uint8_t PB_VALIDATE_FACTORY = 0x01;
+  static constexpr uint8_t PB_AUTOSAVE_PREV    = 0x02;
+  static constexpr uint8_t PB_REPAIR_COUNTERS  = 0x04;
+  static constexpr uint8_t PB_UPTIME_STATS     = 0x08;
+
+  // Флаги EarlyStage::flags
+  static constexpr uint8_t STAGE_FAILS         = 0x01;
+  static constexpr uint8_t STAGE_CLEAR_PENDING = 0x02;
+  static constexpr uint8_t STAGE_OTA_TX        = 0x04;
+  static constexpr uint8_t STAGE_COMPONENT     = 0x08;
+  static constexpr uint8_t STAGE_SIGNATURE     = 0x10;
 
   enum class PendingAction : uint8_t {
     None = 0,
@@ -202,39 +583,113 @@ private:
 
   void log(LogLevel lvl, const char* fmt, ...) const;
 
-  Decision attemptRollback_(Preferences& store, const char* why);
-  Decision tryFactoryFallback_(Preferences& store, Decision failureDecision, const char* cause);
+  Decision decideEarly_();
+  static esp_reset_reason_t readResetReason_();
+  BootTier recommendTier_() const;
+  void markHealthy_(bool fromTimer);
+  static void takeRtcState_(uint8_t& component, uint32_t& uptimeMs);
+  detail::EarlyStage* claimStage_();
+  void stageFails_(uint32_t value);
+  void flushStage_(Store& store);  // writeStage_() + clearStage_()
+  bool writeStage_(Store& store);  // true = stage закоммичен
+  void clearStage_();
+  uint8_t stageFlags_() const;
+#if CRG_FEATURE_ASYNC_PERSIST
+  static void persistTask_(void* arg);
+#endif
+
+#if CRG_FEATURE_ADAPTIVE_STABLE || CRG_FEATURE_CRASH_SIGNATURE
+  uint32_t currentImageTag_();
+#endif
+#if CRG_FEATURE_ADAPTIVE_STABLE
+  void loadUptimeStats_(Store& store, UptimeStatsRecord& rec);
+  bool storeUptimeStats_(Store& store, UptimeStatsRecord& rec) const;
+  void updateAdaptiveWindow_(const UptimeStatsRecord& rec);
+  void recordHealthySample_(Store& store, uint32_t elapsedMs);
+  void refreshUptimeStats_(Store& store);
+#endif
+  Decision attemptRollback_(Store& store, const char* why);
+  Decision guardedRollback_(Store& store, const char* why); // attemptRollback_() под maxRollbackAttempts
+  Decision tryFactoryFallback_(Store& store, Decision failureDecision, const char* cause);
 
   static bool switchBootPartitionByLabel_(const char* label);
   static const esp_partition_t* findAppPartitionByLabel_(const char* label);
 
   static void copyLabel_(char* dst, size_t len, const char* src);
   static bool readRunningLabel_(char* out, size_t len);
-  static bool storeLabelPref_(Preferences& store, const char* key, const char* value);
+  static bool storeLabelPref_(Store& store, const char* key, const char* value);
 
-  static uint32_t crc32_(const void* data, size_t len);
-  bool storeLabelWithCrc_(Preferences& store,
+  uint32_t crc32_(const void* data, size_t len) const;
+  bool storeLabelWithCrc_(Store& store,
                           const char* labelKey,
                           const char* crcKey,
                           const char* value) const;
-  static LabelStatus loadLabelWithCrc_(Preferences& store,
-                                       const char* labelKey,
-                                       const char* crcKey,
-                                       char* out,
-                                       size_t len);
-
-  uint32_t readFailCounter_(Preferences& store, bool allowRepair = true) const;
-  void writeFailCounter_(Preferences& store, uint32_t value) const;
-  void resetFailCounter_(Preferences& store) const;
-
-  uint8_t readRollbackCount_(Preferences& store, bool allowRepair = true) const;
-  void writeRollbackCount_(Preferences& store, uint8_t value) const;
-  void resetRollbackCount_(Preferences& store) const;
-  void bumpRollbackCount_(Preferences& store) const;
-
-  void storePendingAction_(Preferences& store, PendingAction action, const char* label) const;
-  PendingAction readPendingAction_(Preferences& store, char* labelBuf, size_t bufLen) const;
-  void clearPendingAction_(Preferences& store) const;
+  LabelStatus loadLabelWithCrc_(Store& store,
+                                const char* labelKey,
+                                const char* crcKey,
+                                char* out,
+                                size_t len) const;
+
+  uint32_t readFailCounter_(Store& store, bool allowRepair = true, bool* corrupted = nullptr) const;
+  void writeFailCounter_(Store& store, uint32_t value) const;
+  void resetFailCounter_(Store& store) const;
+
+  uint8_t readRollbackCount_(Store& store, bool allowRepair = true) const;
+  void writeRollbackCount_(Store& store, uint8_t value) const;
+  void resetRollbackCount_(Store& store) const;
+  void bumpRollbackCount_(Store& store) const;
+
+#if CRG_FEATURE_CRASH_SIGNATURE
+  static bool readCoreDumpSummary_(CrashSummary& out);
+  static uint32_t signatureOf_(const CrashSummary& summary);
+  void loadSignatureTable_(Store& store, SignatureRecord& rec) const;
+  static uint8_t signatureSlot_(SignatureRecord& rec, uint32_t sig);
+  void storeSignatureTable_(Store& store, SignatureRecord& rec) const;
+  void storeCrashSignature_(Store& store, uint32_t sig, uint8_t hits, uint32_t dumpId) const;
+  bool crashSignatureRepeated_(Store& store);
+#endif
+
+#if CRG_FEATURE_COMPONENTS
+  bool loadComponentRecord_(Store& store, ComponentRecord& rec) const;
+  bool storeComponentRecord_(Store& store, ComponentRecord& rec) const;
+  bool componentCrashAbsorbed_(Store& store, uint8_t id);
+  void storeComponentCount_(Store& store, uint8_t id, uint8_t count) const;
+#endif
+
+  bool storeOtaTx_(Store& store);
+  LabelStatus loadOtaTx_(Store& store, OtaTxRecord& tx) const;
+  bool applyOtaTx_(Store& store, const char* runningLabel);
+
+  void storePendingAction_(Store& store, PendingAction action, const char* label) const;
+  PendingAction readPendingAction_(Store& store, char* labelBuf, size_t bufLen) const;
+  void clearPendingAction_(Store& store) const;
 };
 
+#if CRG_EARLY_BOOT_HOOK
+// Гвард, для которого хук уже выполнил beginEarly() до глобальных конструкторов.
+// В setup() повторно beginEarly() не нужен (он вернёт сохранённое решение),
+// остальное как обычно: markHealthyNow(), loopTick() и т.д.
+CrashRollbackGuard& earlyGuard();
+
+// Переопредели, чтобы настроить earlyGuard(). Вызывается до глобальных
+// конструкторов: не трогай Serial и другие глобальные объекты приложения.
+void configureEarlyBoot(Options& opt);
+#endif
+
+#if CRG_FEATURE_COMPONENTS
+// RAII-маркер: enterComponent(id) в конструкторе, прежний id восстанавливается в деструкторе.
+class ComponentScope {
+public:
+  explicit ComponentScope(uint8_t id) : prev_(detail::rtcState.component) {
+    CrashRollbackGuard::enterComponent(id);
+  }
+  ~ComponentScope() { CrashRollbackGuard::enterComponent(prev_); }
+  ComponentScope(const ComponentScope&) = delete;
+  ComponentScope& operator=(const ComponentScope&) = delete;
+
+private:
+  uint8_t prev_;
+};
+#endif
+
 } // namespace crg
@@ -0,0 +1,165 @@
+#pragma once
+
+// Сборка как компонент ESP-IDF: значения CRG_* по умолчанию берутся из Kconfig
+// (idf.py menuconfig -> CrashRollbackGuard). Явный -D CRG_... по-прежнему важнее.
+// Без Kconfig (Arduino IDE, PlatformIO + arduino) файл ничего не делает.
+
+#if defined(__has_include)
+  #if __has_include("sdkconfig.h")
+    #include "sdkconfig.h"
+  #endif
+#endif
+
+#if defined(CONFIG_CRG_KCONFIG)
+
+#if !defined(CRG_NAMESPACE) && defined(CONFIG_CRG_NAMESPACE)
+  #define CRG_NAMESPACE CONFIG_CRG_NAMESPACE
+#endif
+#if !defined(CRG_FAIL_LIMIT) && defined(CONFIG_CRG_FAIL_LIMIT)
+  #define CRG_FAIL_LIMIT CONFIG_CRG_FAIL_LIMIT
+#endif
+#if !defined(CRG_STABLE_TIME_MS) && defined(CONFIG_CRG_STABLE_TIME_MS)
+  #define CRG_STABLE_TIME_MS ((unsigned long)CONFIG_CRG_STABLE_TIME_MS)
+#endif
+#ifndef CRG_AUTOSAVE_PREV_SLOT
+  #ifdef CONFIG_CRG_AUTOSAVE_PREV_SLOT
+    #define CRG_AUTOSAVE_PREV_SLOT 1
+  #else
+    #define CRG_AUTOSAVE_PREV_SLOT 0
+  #endif
+#endif
+#ifndef CRG_LOG_ENABLED
+  #ifdef CONFIG_CRG_LOG_ENABLED
+    #define CRG_LOG_ENABLED 1
+  #else
+    #define CRG_LOG_ENABLED 0
+  #endif
+#endif
+#if !defined(CRG_LOG_BUFFER_SIZE) && defined(CONFIG_CRG_LOG_BUFFER_SIZE)
+  #define CRG_LOG_BUFFER_SIZE CONFIG_CRG_LOG_BUFFER_SIZE
+#endif
+
+#ifndef CRG_FEATURE_FACTORY_FALLBACK
+  #ifdef CONFIG_CRG_FEATURE_FACTORY_FALLBACK
+    #define CRG_FEATURE_FACTORY_FALLBACK 1
+  #else
+    #define CRG_FEATURE_FACTORY_FALLBACK 0
+  #endif
+#endif
+#ifndef CRG_FEATURE_STABLE_TICK
+  #ifdef CONFIG_CRG_FEATURE_STABLE_TICK
+    #define CRG_FEATURE_STABLE_TICK 1
+  #else
+    #define CRG_FEATURE_STABLE_TICK 0
+  #endif
+#endif
+#ifndef CRG_FEATURE_PENDING_VERIFY_FIX
+  #ifdef CONFIG_CRG_FEATURE_PENDING_VERIFY_FIX
+    #define CRG_FEATURE_PENDING_VERIFY_FIX 1
+  #else
+    #define CRG_FEATURE_PENDING_VERIFY_FIX 0
+  #endif
+#endif
+#ifndef CRG_FEATURE_STORE_STATS
+  #ifdef CONFIG_CRG_FEATURE_STORE_STATS
+    #define CRG_FEATURE_STORE_STATS 1
+  #else
+    #define CRG_FEATURE_STORE_STATS 0
+  #endif
+#endif
+
+#ifndef CRG_STORAGE_BACKEND
+  #if defined(CONFIG_CRG_STORAGE_FLASHLOG)
+    #define CRG_STORAGE_BACKEND CRG_STORAGE_FLASHLOG
+  #else
+    #define CRG_STORAGE_BACKEND CRG_STORAGE_NVS
+  #endif
+#endif
+#if !defined(CRG_FLASHLOG_PARTITION) && defined(CONFIG_CRG_FLASHLOG_PARTITION)
+  #define CRG_FLASHLOG_PARTITION CONFIG_CRG_FLASHLOG_PARTITION
+#endif
+#if !defined(CRG_FLASHLOG_ENTRY_SIZE) && defined(CONFIG_CRG_FLASHLOG_ENTRY_SIZE)
+  #define CRG_FLASHLOG_ENTRY_SIZE CONFIG_CRG_FLASHLOG_ENTRY_SIZE
+#endif
+
+#ifndef CRG_FEATURE_COMPONENTS
+  #ifdef CONFIG_CRG_FEATURE_COMPONENTS
+    #define CRG_FEATURE_COMPONENTS 1
+  #else
+    #define CRG_FEATURE_COMPONENTS 0
+  #endif
+#endif
+#if !defined(CRG_MAX_COMPONENTS) && defined(CONFIG_CRG_MAX_COMPONENTS)
+  #define CRG_MAX_COMPONENTS CONFIG_CRG_MAX_COMPONENTS
+#endif
+#if !defined(CRG_MAX_SERVICES) && defined(CONFIG_CRG_MAX_SERVICES)
+  #define CRG_MAX_SERVICES CONFIG_CRG_MAX_SERVICES
+#endif
+
+#ifndef CRG_EARLY_BOOT_HOOK
+  #ifdef CONFIG_CRG_EARLY_BOOT_HOOK
+    #define CRG_EARLY_BOOT_HOOK 1
+  #else
+    #define CRG_EARLY_BOOT_HOOK 0
+  #endif
+#endif
+#if !defined(CRG_EARLY_BOOT_PRIORITY) && defined(CONFIG_CRG_EARLY_BOOT_PRIORITY)
+  #define CRG_EARLY_BOOT_PRIORITY CONFIG_CRG_EARLY_BOOT_PRIORITY
+#endif
+
+#if !defined(CRG_EARLY_STAGE_SLOTS) && defined(CONFIG_CRG_EARLY_STAGE_SLOTS)
+  #define CRG_EARLY_STAGE_SLOTS CONFIG_CRG_EARLY_STAGE_SLOTS
+#endif
+
+#ifndef CRG_FEATURE_ASYNC_PERSIST
+  #ifdef CONFIG_CRG_FEATURE_ASYNC_PERSIST
+    #define CRG_FEATURE_ASYNC_PERSIST 1
+  #else
+    #define CRG_FEATURE_ASYNC_PERSIST 0
+  #endif
+#endif
+#if !defined(CRG_PERSIST_TASK_STACK) && defined(CONFIG_CRG_PERSIST_TASK_STACK)
+  #define CRG_PERSIST_TASK_STACK CONFIG_CRG_PERSIST_TASK_STACK
+#endif
+
+#ifndef CRG_FEATURE_ADAPTIVE_STABLE
+  #ifdef CONFIG_CRG_FEATURE_ADAPTIVE_STABLE
+    #define CRG_FEATURE_ADAPTIVE_STABLE 1
+  #else
+    #define CRG_FEATURE_ADAPTIVE_STABLE 0
+  #endif
+#endif
+#if !defined(CRG_STATS_SAMPLES) && defined(CONFIG_CRG_STATS_SAMPLES)
+  #define CRG_STATS_SAMPLES CONFIG_CRG_STATS_SAMPLES
+#endif
+#if !defined(CRG_STATS_MIN_SAMPLES) && defined(CONFIG_CRG_STATS_MIN_SAMPLES)
+  #define CRG_STATS_MIN_SAMPLES CONFIG_CRG_STATS_MIN_SAMPLES
+#endif
+
+#ifndef CRG_FEATURE_CRASH_SIGNATURE
+  #ifdef CONFIG_CRG_FEATURE_CRASH_SIGNATURE
+    #define CRG_FEATURE_CRASH_SIGNATURE 1
+  #else
+    #define CRG_FEATURE_CRASH_SIGNATURE 0
+  #endif
+#endif
+#if !defined(CRG_SIGNATURE_SLOTS) && defined(CONFIG_CRG_SIGNATURE_SLOTS)
+  #define CRG_SIGNATURE_SLOTS CONFIG_CRG_SIGNATURE_SLOTS
+#endif
+#if !defined(CRG_SIGNATURE_BT_DEPTH) && defined(CONFIG_CRG_SIGNATURE_BT_DEPTH)
+  #define CRG_SIGNATURE_BT_DEPTH CONFIG_CRG_SIGNATURE_BT_DEPTH
+#endif
+
+#ifndef CRG_INTEGRITY_BACKEND
+  #if defined(CONFIG_CRG_INTEGRITY_BITWISE)
+    #define CRG_INTEGRITY_BACKEND CRG_CRC_BITWISE
+  #elif defined(CONFIG_CRG_INTEGRITY_TABLE)
+    #define CRG_INTEGRITY_BACKEND CRG_CRC_TABLE
+  #elif defined(CONFIG_CRG_INTEGRITY_SLICE8)
+    #define CRG_INTEGRITY_BACKEND CRG_CRC_SLICE8
+  #else
+    #define CRG_INTEGRITY_BACKEND CRG_CRC_ROM
+  #endif
+#endif
+
+#endif // CONFIG_CRG_KCONFIG
@@ -0,0 +1,277 @@
+#include "CrgFlashLog.h"
+
+#include <string.h>
+
+#include "esp_partition.h"
+#include "nvs.h"
+
+#include "CrgIntegrity.h"
+
+namespace crg {
+namespace flashlog {
+
+namespace {
+
+// Entry layout (little-endian, ENTRY_SIZE bytes):
+//   0  magic   4  crc   8  seq   12 used   14 reserved   16 payload[used]
+// crc covers bytes 8..15 and the used part of the payload. Payload records:
+//   u32 keyHash, u16 nsTag, u16 len, value[len]
+constexpr uint32_t kMagic = 0x4C475243u; // "CRGL"
+constexpr uint32_t kErased = 0xFFFFFFFFu;
+constexpr size_t kHeaderSize = HEADER_SIZE;
+constexpr size_t kPayloadSize = PAYLOAD_SIZE;
+constexpr size_t kRecordHeader = RECORD_HEADER;
+constexpr size_t kSlots = 2 * SLOTS_PER_SECTOR;
+
+// The RAM image doubles as the write buffer for append().
+uint8_t g_entry[ENTRY_SIZE];
+uint16_t g_used = 0;
+Info g_info;
+bool g_mounted = false;
+
+const esp_partition_t* g_partition = nullptr;
+
+esp_err_t partitionRead_(size_t offset, void* dst, size_t len) {
+  return esp_partition_read(g_partition, offset, dst, len);
+}
+
+esp_err_t partitionWrite_(size_t offset, const void* src, size_t len) {
+  return esp_partition_write(g_partition, offset, src, len);
+}
+
+esp_err_t partitionErase_(size_t offset, size_t len) {
+  return esp_partition_erase_range(g_partition, offset, len);
+}
+
+constexpr FlashIo kPartitionIo{partitionRead_, partitionWrite_, partitionErase_};
+const FlashIo* g_io = nullptr;
+
+bool bindPartition_() {
+  if (g_io) return true;
+  g_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         CRG_FLASHLOG_PARTITION);
+  if (!g_partition || g_partition->size < 2 * SECTOR_SIZE) return false;
+  g_io = &kPartitionIo;
+  return true;
+}
+
+uint32_t get32_(const uint8_t* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint16_t get16_(const uint8_t* p) {
+  uint16_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+size_t slotOffset_(size_t sector, size_t slot) {
+  return sector * SECTOR_SIZE + slot * ENTRY_SIZE;
+}
+
+uint32_t entryCrc_(const uint8_t* entry, uint16_t used) {
+  return integrity::crc32(entry + 8, kHeaderSize - 8 + used);
+}
+
+// Loads the slot into g_entry and checks it; g_entry is garbage on failure.
+bool loadEntry_(size_t offset) {
+  if (g_io->read(offset, g_entry, ENTRY_SIZE) != ESP_OK) return false;
+  const uint16_t used = get16_(g_entry + 12);
+  if (get32_(g_entry) != kMagic || used > kPayloadSize) return false;
+  return entryCrc_(g_entry, used) == get32_(g_entry + 4);
+}
+
+// Walks the payload; returns the offset of the record or kPayloadSize.
+size_t locate_(uint32_t hash) {
+  size_t pos = 0;
+  while (pos + kRecordHeader <= g_used) {
+    const size_t len = get16_(g_entry + kHeaderSize + pos + 6);
+    if (get32_(g_entry + kHeaderSize + pos) == hash) return pos;
+    pos += kRecordHeader + len;
+  }
+  return kPayloadSize;
+}
+
+void cut_(size_t pos) {
+  uint8_t* payload = g_entry + kHeaderSize;
+  const size_t size = kRecordHeader + get16_(payload + pos + 6);
+  memmove(payload + pos, payload + pos + size, g_used - pos - size);
+  g_used = static_cast<uint16_t>(g_used - size);
+}
+
+// Writes g_entry to the slot and reads it back in small chunks.
+bool program_(size_t offset) {
+  if (g_io->write(offset, g_entry, ENTRY_SIZE) != ESP_OK) return false;
+  uint8_t chunk[64];
+  for (size_t done = 0; done < ENTRY_SIZE; done += sizeof(chunk)) {
+    const size_t n = ENTRY_SIZE - done < sizeof(chunk) ? ENTRY_SIZE - done : sizeof(chunk);
+    if (g_io->read(offset + done, chunk, n) != ESP_OK || memcmp(chunk, g_entry + done, n) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+void setFlashIo(const FlashIo* io) {
+  g_io = io;
+  g_partition = nullptr;
+  g_mounted = false;
+}
+
+const Info& info() {
+  g_info.used = g_used;
+  g_info.capacity = static_cast<uint16_t>(kPayloadSize);
+  return g_info;
+}
+
+bool mount() {
+  if (g_mounted) return true;
+  if (!bindPartition_()) return false;
+
+  // Pass 1: headers only. Remember every slot that claims to be an entry.
+  struct Candidate {
+    uint32_t seq;
+    uint8_t index;
+  };
+  Candidate candidates[kSlots];
+  size_t count = 0;
+  bool erased[kSlots];
+  for (size_t i = 0; i < kSlots; ++i) {
+    uint32_t head[3] = {kErased, kErased, kErased};
+    const size_t offset = slotOffset_(i / SLOTS_PER_SECTOR, i % SLOTS_PER_SECTOR);
+    if (g_io->read(offset, head, sizeof(head)) != ESP_OK) return false;
+    erased[i] = head[0] == kErased;
+    if (head[0] == kMagic) candidates[count++] = Candidate{head[2], static_cast<uint8_t>(i)};
+  }
+
+  // Pass 2: newest first until one passes its CRC (torn writes fall through).
+  g_info = Info{};
+  g_used = 0;
+  size_t newest = kSlots;
+  while (count > 0) {
+    size_t best = 0;
+    for (size_t i = 1; i < count; ++i) {
+      if (static_cast<int32_t>(candidates[i].seq - candidates[best].seq) > 0) best = i;
+    }
+    const uint8_t index = candidates[best].index;
+    candidates[best] = candidates[--count];
+    if (loadEntry_(slotOffset_(index / SLOTS_PER_SECTOR, index % SLOTS_PER_SECTOR))) {
+      newest = index;
+      break;
+    }
+  }
+
+  if (newest == kSlots) {
+    memset(g_entry, 0xFF, ENTRY_SIZE);
+  } else {
+    g_used = get16_(g_entry + 12);
+    g_info.sequence = get32_(g_entry + 8);
+    g_info.sector = static_cast<uint8_t>(newest / SLOTS_PER_SECTOR);
+  }
+
+  // Next write goes to the first erased slot after the newest entry.
+  const size_t first = newest == kSlots ? 0 : newest % SLOTS_PER_SECTOR + 1;
+  size_t slot = first;
+  while (slot < SLOTS_PER_SECTOR && !erased[g_info.sector * SLOTS_PER_SECTOR + slot]) ++slot;
+  g_info.nextSlot = static_cast<uint8_t>(slot);
+  g_mounted = true;
+  return true;
+}
+
+uint32_t keyHash(const char* ns, const char* key) {
+  // "ns/key"; NVS limits both names to 15 characters.
+  char name[2 * (NVS_KEY_NAME_MAX_SIZE - 1) + 1];
+  const size_t nsLen = strnlen(ns, NVS_KEY_NAME_MAX_SIZE - 1);
+  const size_t keyLen = strnlen(key, NVS_KEY_NAME_MAX_SIZE - 1);
+  memcpy(name, ns, nsLen);
+  name[nsLen] = '/';
+  memcpy(name + nsLen + 1, key, keyLen);
+  return integrity::crc32(name, nsLen + 1 + keyLen);
+}
+
+uint16_t nsTag(const char* ns) {
+  return static_cast<uint16_t>(integrity::crc32(ns, strnlen(ns, NVS_KEY_NAME_MAX_SIZE - 1)));
+}
+
+const uint8_t* find(uint32_t hash, size_t* len) {
+  const size_t pos = locate_(hash);
+  if (pos == kPayloadSize) return nullptr;
+  const uint8_t* record = g_entry + kHeaderSize + pos;
+  if (len) *len = get16_(record + 6);
+  return record + kRecordHeader;
+}
+
+bool set(uint32_t hash, uint16_t tag, const void* value, size_t len) {
+  const size_t pos = locate_(hash);
+  const size_t old = pos == kPayloadSize ? 0 : kRecordHeader + get16_(g_entry + kHeaderSize + pos + 6);
+  if (g_used - old + kRecordHeader + len > kPayloadSize) return false;
+  if (pos != kPayloadSize) cut_(pos);
+  uint8_t* record = g_entry + kHeaderSize + g_used;
+  const uint16_t len16 = static_cast<uint16_t>(len);
+  memcpy(record, &hash, sizeof(hash));
+  memcpy(record + 4, &tag, sizeof(tag));
+  memcpy(record + 6, &len16, sizeof(len16));
+  memcpy(record + kRecordHeader, value, len);
+  g_used = static_cast<uint16_t>(g_used + kRecordHeader + len);
+  return true;
+}
+
+bool erase(uint32_t hash) {
+  const size_t pos = locate_(hash);
+  if (pos == kPayloadSize) return false;
+  cut_(pos);
+  return true;
+}
+
+void eraseNamespace(uint16_t tag) {
+  size_t pos = 0;
+  while (pos + kRecordHeader <= g_used) {
+    if (get16_(g_entry + kHeaderSize + pos + 4) == tag) {
+      cut_(pos);
+    } else {
+      pos += kRecordHeader + get16_(g_entry + kHeaderSize + pos + 6);
+    }
+  }
+}
+
+bool append() {
+  if (!g_mounted) return false;
+  const uint32_t seq = g_info.sequence + 1;
+  const uint32_t magic = kMagic;
+  const uint16_t reserved = 0xFFFF;
+  memcpy(g_entry, &magic, sizeof(magic));
+  memcpy(g_entry + 8, &seq, sizeof(seq));
+  memcpy(g_entry + 12, &g_used, sizeof(g_used));
+  memcpy(g_entry + 14, &reserved, sizeof(reserved));
+  memset(g_entry + kHeaderSize + g_used, 0xFF, kPayloadSize - g_used);
+  const uint32_t crc = entryCrc_(g_entry, g_used);
+  memcpy(g_entry + 4, &crc, sizeof(crc));
+
+  // A slot that fails read-back (torn or never erased) is skipped. The
+  // newest entry stays valid until the other sector has taken a new one.
+  for (size_t attempt = 0; attempt < kSlots; ++attempt) {
+    if (g_info.nextSlot >= SLOTS_PER_SECTOR) {
+      const uint8_t other = static_cast<uint8_t>(g_info.sector ^ 1u);
+      if (g_io->erase(slotOffset_(other, 0), SECTOR_SIZE) != ESP_OK) return false;
+      ++g_info.erases;
+      g_info.sector = other;
+      g_info.nextSlot = 0;
+    }
+    const size_t offset = slotOffset_(g_info.sector, g_info.nextSlot++);
+    uint32_t head = 0;
+    if (g_io->read(offset, &head, sizeof(head)) != ESP_OK) return false;
+    if (head != kErased) continue;
+    if (program_(offset)) {
+      g_info.sequence = seq;
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace flashlog
+} // namespace crg
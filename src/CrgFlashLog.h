@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "CrgConfig.h"
+
+#ifndef CRG_FLASHLOG_PARTITION
+  // Label data-раздела под журнал (нужно минимум два сектора по 4 КБ).
+  #define CRG_FLASHLOG_PARTITION "crglog"
+#endif
+
+#ifndef CRG_FLASHLOG_ENTRY_SIZE
+  // Размер одной записи журнала (снимок всех ключей гварда), делитель 4096.
+  #define CRG_FLASHLOG_ENTRY_SIZE 512
+#endif
+
+namespace crg {
+namespace flashlog {
+
+// Журнал на сыром flash: два сектора по очереди (ping-pong), в каждом —
+// записи фиксированного размера с порядковым номером и CRC. Каждая запись —
+// полный снимок ключей, актуальна запись с наибольшим номером. Сектор
+// стирается, только когда другой заполнен.
+
+static constexpr size_t SECTOR_SIZE = 4096;
+static constexpr size_t ENTRY_SIZE = CRG_FLASHLOG_ENTRY_SIZE;
+static constexpr size_t SLOTS_PER_SECTOR = SECTOR_SIZE / ENTRY_SIZE;
+static_assert(SECTOR_SIZE % ENTRY_SIZE == 0 && SLOTS_PER_SECTOR >= 2,
+              "CRG_FLASHLOG_ENTRY_SIZE must divide 4096 at least twice");
+static constexpr size_t HEADER_SIZE = 16;                       // заголовок записи
+static constexpr size_t PAYLOAD_SIZE = ENTRY_SIZE - HEADER_SIZE; // все ключи всех namespace
+static constexpr size_t RECORD_HEADER = 8;                      // перед каждым значением
+
+// Доступ к flash (смещения от начала журнала). По умолчанию — esp_partition_*
+// для CRG_FLASHLOG_PARTITION; симулятор на хосте подставляет свои функции.
+struct FlashIo {
+  esp_err_t (*read)(size_t offset, void* dst, size_t len);
+  esp_err_t (*write)(size_t offset, const void* src, size_t len);
+  esp_err_t (*erase)(size_t offset, size_t len);
+};
+void setFlashIo(const FlashIo* io); // nullptr = раздел; сбрасывает RAM-образ
+
+// Состояние журнала после mount()
+struct Info {
+  uint32_t sequence = 0; // номер последней записи (0 = журнал пуст)
+  uint8_t  sector   = 0; // активный сектор
+  uint8_t  nextSlot = 0; // куда пойдёт следующая запись
+  uint32_t erases   = 0; // стираний сектора с момента загрузки
+  uint16_t used     = 0; // занято байт полезной нагрузки записи
+  uint16_t capacity = 0; // ENTRY_SIZE минус заголовок
+};
+const Info& info();
+
+// Поиск последней целой записи: не больше 2 * SLOTS_PER_SECTOR чтений заголовков.
+bool mount();
+
+// RAM-образ последней записи. Ключ — хеш (namespace, key), nsTag — для clear().
+uint32_t keyHash(const char* ns, const char* key);
+uint16_t nsTag(const char* ns);
+const uint8_t* find(uint32_t hash, size_t* len);
+bool set(uint32_t hash, uint16_t tag, const void* value, size_t len);
+bool erase(uint32_t hash);
+void eraseNamespace(uint16_t tag);
+
+// Дописать RAM-образ новой записью (при заполнении — в другой сектор).
+bool append();
+
+} // namespace flashlog
+} // namespace crg
@@ -0,0 +1,127 @@
+#include "CrgIntegrity.h"
+
+#if defined(ESP_PLATFORM)
+  #include "esp_rom_crc.h"
+#endif
+
+namespace crg {
+namespace integrity {
+
+namespace {
+
+constexpr uint32_t kPoly = 0xEDB88320u;
+
+struct Crc32Table {
+  uint32_t t[256];
+};
+
+struct Crc32Tables {
+  uint32_t t[8][256];
+};
+
+// Tables are generated at compile time and land in .rodata (flash). The table
+// backend has its own 1 KB table so it does not pull in the 8 KB slice set.
+constexpr Crc32Table makeTable() {
+  Crc32Table table{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1u) ? kPoly : 0u);
+    }
+    table.t[i] = crc;
+  }
+  return table;
+}
+
+constexpr Crc32Table kTable = makeTable();
+
+constexpr Crc32Tables makeTables() {
+  Crc32Tables tables{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    tables.t[0][i] = kTable.t[i];
+  }
+  for (uint32_t i = 0; i < 256; ++i) {
+    for (uint8_t slice = 1; slice < 8; ++slice) {
+      const uint32_t prev = tables.t[slice - 1][i];
+      tables.t[slice][i] = (prev >> 8) ^ tables.t[0][prev & 0xFFu];
+    }
+  }
+  return tables;
+}
+
+constexpr Crc32Tables kTables = makeTables();
+
+static_assert(kTable.t[1] == 0x77073096u, "CRC-32 table generation broken");
+static_assert(sizeof(kTable) == 1024, "table backend must stay at 1 KB");
+
+} // namespace
+
+uint32_t crc32Bitwise(const void* data, size_t len, uint32_t crc) {
+  const uint8_t* ptr = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  while (len--) {
+    crc ^= *ptr++;
+    for (uint8_t i = 0; i < 8; ++i) {
+      const uint32_t mask = -(crc & 1u);
+      crc = (crc >> 1) ^ (kPoly & mask);
+    }
+  }
+  return ~crc;
+}
+
+uint32_t crc32Table(const void* data, size_t len, uint32_t crc) {
+  const uint8_t* ptr = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  while (len--) {
+    crc = (crc >> 8) ^ kTable.t[(crc ^ *ptr++) & 0xFFu];
+  }
+  return ~crc;
+}
+
+uint32_t crc32Slice8(const void* data, size_t len, uint32_t crc) {
+  const uint8_t* ptr = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  // Byte-wise assembly keeps this alignment- and endian-agnostic.
+  while (len >= 8) {
+    const uint32_t lo = crc ^ (static_cast<uint32_t>(ptr[0]) |
+                               static_cast<uint32_t>(ptr[1]) << 8 |
+                               static_cast<uint32_t>(ptr[2]) << 16 |
+                               static_cast<uint32_t>(ptr[3]) << 24);
+    crc = kTables.t[7][lo & 0xFFu] ^
+          kTables.t[6][(lo >> 8) & 0xFFu] ^
+          kTables.t[5][(lo >> 16) & 0xFFu] ^
+          kTables.t[4][lo >> 24] ^
+          kTables.t[3][ptr[4]] ^
+          kTables.t[2][ptr[5]] ^
+          kTables.t[1][ptr[6]] ^
+          kTables.t[0][ptr[7]];
+    ptr += 8;
+    len -= 8;
+  }
+  while (len--) {
+    crc = (crc >> 8) ^ kTables.t[0][(crc ^ *ptr++) & 0xFFu];
+  }
+  return ~crc;
+}
+
+#if defined(ESP_PLATFORM)
+uint32_t crc32Rom(const void* data, size_t len, uint32_t crc) {
+  // ROM crc32_le inverts on entry and exit, matching zlib semantics.
+  return esp_rom_crc32_le(crc, static_cast<const uint8_t*>(data), static_cast<uint32_t>(len));
+}
+#endif
+
+uint32_t crc32(const void* data, size_t len) {
+#if CRG_INTEGRITY_BACKEND == CRG_CRC_ROM && defined(ESP_PLATFORM)
+  return crc32Rom(data, len);
+#elif CRG_INTEGRITY_BACKEND == CRG_CRC_SLICE8
+  return crc32Slice8(data, len);
+#elif CRG_INTEGRITY_BACKEND == CRG_CRC_TABLE
+  return crc32Table(data, len);
+#else
+  return crc32Bitwise(data, len);
+#endif
+}
+
+} // namespace integrity
+} // namespace crg
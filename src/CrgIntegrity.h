@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CrgConfig.h"
+
+//==================== Integrity backends ====================
+// Все реализации считают один и тот же CRC-32 (IEEE 802.3, как zlib),
+// поэтому записи, сохранённые одним бэкендом, читаются любым другим.
+
+#define CRG_CRC_BITWISE 0 // по биту за шаг, без таблиц
+#define CRG_CRC_TABLE   1 // таблица 256 x uint32 (1 КБ flash)
+#define CRG_CRC_SLICE8  2 // slicing-by-8, таблица 8 x 256 x uint32 (8 КБ flash)
+#define CRG_CRC_ROM     3 // esp_rom_crc32_le() из ROM чипа
+
+#ifndef CRG_INTEGRITY_BACKEND
+  #if defined(ESP_PLATFORM)
+    #define CRG_INTEGRITY_BACKEND CRG_CRC_ROM
+  #else
+    #define CRG_INTEGRITY_BACKEND CRG_CRC_SLICE8
+  #endif
+#endif
+
+namespace crg {
+
+// Функция целостности для всех записей гварда (метки, счётчики, таблицы).
+// Это 32-битная контрольная сумма без ключа: защищает от порчи flash,
+// но не от намеренной подмены записей.
+using IntegrityFn = uint32_t (*)(const void* data, size_t len);
+
+namespace integrity {
+
+// crc — результат для предыдущего куска (0 для начала), как в zlib crc32().
+uint32_t crc32Bitwise(const void* data, size_t len, uint32_t crc = 0);
+uint32_t crc32Table(const void* data, size_t len, uint32_t crc = 0);
+uint32_t crc32Slice8(const void* data, size_t len, uint32_t crc = 0);
+#if defined(ESP_PLATFORM)
+uint32_t crc32Rom(const void* data, size_t len, uint32_t crc = 0);
+#endif
+
+// Бэкенд, выбранный CRG_INTEGRITY_BACKEND
+uint32_t crc32(const void* data, size_t len);
+
+} // namespace integrity
+} // namespace crg
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CrgConfig.h"
+
+// Arduino-слой (Print, String, Serial) — только поверх arduino-esp32.
+// Ядро гварда использует лишь ESP-IDF: nvs, esp_timer, esp_log.
+#ifndef CRG_ARDUINO
+  #if defined(ARDUINO)
+    #define CRG_ARDUINO 1
+  #else
+    #define CRG_ARDUINO 0
+  #endif
+#endif
+
+#if CRG_ARDUINO
+  #include <Arduino.h>
+#endif
+
+#include "esp_timer.h"
+
+namespace crg {
+namespace platform {
+
+// Время с момента старта (переполняются как millis()/micros()).
+inline uint32_t millisNow() { return static_cast<uint32_t>(esp_timer_get_time() / 1000); }
+inline uint32_t microsNow() { return static_cast<uint32_t>(esp_timer_get_time()); }
+
+} // namespace platform
+} // namespace crg
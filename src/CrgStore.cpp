@@ -0,0 +1,304 @@
+#include "CrgStore.h"
+
+#include <string.h>
+
+#include "esp_idf_version.h"
+
+#if CRG_STORAGE_BACKEND == CRG_STORAGE_FLASHLOG
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/semphr.h"
+  #include "freertos/task.h"
+
+  #include "CrgFlashLog.h"
+#endif
+
+namespace crg {
+
+namespace {
+
+StoreStats g_stats;
+
+#if CRG_FEATURE_STORE_STATS
+  #define CRG_STAT(field) (++g_stats.field)
+#else
+  #define CRG_STAT(field) ((void)0)
+#endif
+
+} // namespace
+
+const StoreStats& storeStats() { return g_stats; }
+
+void resetStoreStats() { g_stats = StoreStats{}; }
+
+#if CRG_STORAGE_BACKEND == CRG_STORAGE_FLASHLOG
+
+// Flash-log backend: the whole log is one RAM image (see CrgFlashLog.h), so
+// get* never touch flash and a session costs one appended entry. Sessions are
+// serialized with a recursive mutex once the scheduler runs.
+
+namespace {
+
+// A function-local static: its first call is serialized by the C++ runtime
+// (ESP-IDF implements the guard with FreeRTOS), so two tasks opening their
+// first session at once get the same mutex. It also works from the early boot
+// hook, before namespace-scope objects are constructed.
+SemaphoreHandle_t lock_() {
+  static StaticSemaphore_t buf;
+  static const SemaphoreHandle_t lock = xSemaphoreCreateRecursiveMutexStatic(&buf);
+  return lock;
+}
+
+bool schedulerRunning_() {
+  return xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+}
+
+} // namespace
+
+bool Store::begin(const char* ns, bool readOnly) {
+  if (open_ || !ns) return false;
+  CRG_STAT(opens);
+  if (schedulerRunning_()) xSemaphoreTakeRecursive(lock_(), portMAX_DELAY);
+  if (!flashlog::mount()) {
+    if (schedulerRunning_()) xSemaphoreGiveRecursive(lock_());
+    return false;
+  }
+  strncpy(ns_, ns, sizeof(ns_) - 1);
+  ns_[sizeof(ns_) - 1] = '\0';
+  readOnly_ = readOnly;
+  dirty_ = false;
+  open_ = true;
+  return true;
+}
+
+void Store::end() {
+  if (!open_) return;
+  commit();
+  open_ = false;
+  if (schedulerRunning_()) xSemaphoreGiveRecursive(lock_());
+}
+
+bool Store::commit() {
+  if (!open_) return false;
+  if (!dirty_) return true;
+  CRG_STAT(commits);
+  dirty_ = false;
+  return flashlog::append();
+}
+
+const uint8_t* Store::find_(const char* key, size_t* len) {
+  if (!open_ || !key) return nullptr;
+  return flashlog::find(flashlog::keyHash(ns_, key), len);
+}
+
+bool Store::set_(const char* key, const void* value, size_t len) {
+  if (!open_ || readOnly_ || !key) return false;
+  size_t oldLen = 0;
+  const uint8_t* old = find_(key, &oldLen);
+  if (old && oldLen == len && memcmp(old, value, len) == 0) return true;
+  if (!flashlog::set(flashlog::keyHash(ns_, key), flashlog::nsTag(ns_), value, len)) return false;
+  dirty_ = true;
+  return true;
+}
+
+// Return values follow Preferences: bytes written/read, 0 on failure.
+// Integers are matched by size, like typed NVS entries.
+
+uint32_t Store::getUInt(const char* key, uint32_t defaultValue) {
+  CRG_STAT(reads);
+  size_t len = 0;
+  const uint8_t* value = find_(key, &len);
+  if (!value || len != sizeof(uint32_t)) return defaultValue;
+  uint32_t out;
+  memcpy(&out, value, sizeof(out));
+  return out;
+}
+
+size_t Store::putUInt(const char* key, uint32_t value) {
+  CRG_STAT(writes);
+  return set_(key, &value, sizeof(value)) ? sizeof(value) : 0;
+}
+
+uint8_t Store::getUChar(const char* key, uint8_t defaultValue) {
+  CRG_STAT(reads);
+  size_t len = 0;
+  const uint8_t* value = find_(key, &len);
+  return value && len == sizeof(uint8_t) ? *value : defaultValue;
+}
+
+size_t Store::putUChar(const char* key, uint8_t value) {
+  CRG_STAT(writes);
+  return set_(key, &value, sizeof(value)) ? sizeof(value) : 0;
+}
+
+size_t Store::getString(const char* key, char* out, size_t len) {
+  CRG_STAT(reads);
+  size_t need = 0;
+  const uint8_t* value = find_(key, &need);
+  if (!value || !out || need == 0 || need > len || value[need - 1] != '\0') return 0;
+  memcpy(out, value, need);
+  return need; // includes the terminator
+}
+
+size_t Store::putString(const char* key, const char* value) {
+  CRG_STAT(writes);
+  if (!value) return 0;
+  const size_t len = strlen(value);
+  return set_(key, value, len + 1) ? len : 0;
+}
+
+size_t Store::getBytes(const char* key, void* out, size_t len) {
+  CRG_STAT(reads);
+  size_t need = 0;
+  const uint8_t* value = find_(key, &need);
+  if (!value || !out || need > len) return 0;
+  memcpy(out, value, need);
+  return need;
+}
+
+size_t Store::putBytes(const char* key, const void* value, size_t len) {
+  CRG_STAT(writes);
+  if (!value) return 0;
+  return set_(key, value, len) ? len : 0;
+}
+
+bool Store::isKey(const char* key) {
+  CRG_STAT(reads);
+  return find_(key, nullptr) != nullptr;
+}
+
+bool Store::remove(const char* key) {
+  CRG_STAT(writes);
+  if (!open_ || readOnly_ || !key || !flashlog::erase(flashlog::keyHash(ns_, key))) return false;
+  dirty_ = true;
+  return true;
+}
+
+bool Store::clear() {
+  CRG_STAT(writes);
+  if (!open_ || readOnly_) return false;
+  flashlog::eraseNamespace(flashlog::nsTag(ns_));
+  dirty_ = true;
+  return true;
+}
+
+#else
+
+bool Store::begin(const char* ns, bool readOnly) {
+  if (open_) return false;
+  CRG_STAT(opens);
+  open_ = nvs_open(ns, readOnly ? NVS_READONLY : NVS_READWRITE, &handle_) == ESP_OK;
+  dirty_ = false;
+  return open_;
+}
+
+void Store::end() {
+  if (!open_) return;
+  commit();
+  nvs_close(handle_);
+  open_ = false;
+}
+
+bool Store::commit() {
+  if (!open_) return false;
+  if (!dirty_) return true;
+  CRG_STAT(commits);
+  dirty_ = false;
+  return nvs_commit(handle_) == ESP_OK;
+}
+
+// Return values follow Preferences: bytes written/read, 0 on failure.
+
+uint32_t Store::getUInt(const char* key, uint32_t defaultValue) {
+  CRG_STAT(reads);
+  uint32_t value = defaultValue;
+  if (!open_ || nvs_get_u32(handle_, key, &value) != ESP_OK) return defaultValue;
+  return value;
+}
+
+size_t Store::putUInt(const char* key, uint32_t value) {
+  CRG_STAT(writes);
+  if (!open_ || nvs_set_u32(handle_, key, value) != ESP_OK) return 0;
+  dirty_ = true;
+  return sizeof(value);
+}
+
+uint8_t Store::getUChar(const char* key, uint8_t defaultValue) {
+  CRG_STAT(reads);
+  uint8_t value = defaultValue;
+  if (!open_ || nvs_get_u8(handle_, key, &value) != ESP_OK) return defaultValue;
+  return value;
+}
+
+size_t Store::putUChar(const char* key, uint8_t value) {
+  CRG_STAT(writes);
+  if (!open_ || nvs_set_u8(handle_, key, value) != ESP_OK) return 0;
+  dirty_ = true;
+  return sizeof(value);
+}
+
+size_t Store::getString(const char* key, char* out, size_t len) {
+  CRG_STAT(reads);
+  size_t need = 0;
+  if (!open_ || !out || nvs_get_str(handle_, key, nullptr, &need) != ESP_OK || need > len) return 0;
+  if (nvs_get_str(handle_, key, out, &need) != ESP_OK) return 0;
+  return need; // includes the terminator
+}
+
+size_t Store::putString(const char* key, const char* value) {
+  CRG_STAT(writes);
+  if (!open_ || !value || nvs_set_str(handle_, key, value) != ESP_OK) return 0;
+  dirty_ = true;
+  return strlen(value);
+}
+
+size_t Store::getBytes(const char* key, void* out, size_t len) {
+  CRG_STAT(reads);
+  size_t need = 0;
+  if (!open_ || !out || nvs_get_blob(handle_, key, nullptr, &need) != ESP_OK || need > len) return 0;
+  if (nvs_get_blob(handle_, key, out, &need) != ESP_OK) return 0;
+  return need;
+}
+
+size_t Store::putBytes(const char* key, const void* value, size_t len) {
+  CRG_STAT(writes);
+  if (!open_ || !value || nvs_set_blob(handle_, key, value, len) != ESP_OK) return 0;
+  dirty_ = true;
+  return len;
+}
+
+bool Store::isKey(const char* key) {
+  CRG_STAT(reads);
+  if (!open_) return false;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+  return nvs_find_key(handle_, key, nullptr) == ESP_OK;
+#else
+  // Older IDF has no type-agnostic lookup; the guard only stores these types.
+  uint8_t u8;
+  uint32_t u32;
+  size_t len = 0;
+  return nvs_get_u32(handle_, key, &u32) == ESP_OK ||
+         nvs_get_blob(handle_, key, nullptr, &len) == ESP_OK ||
+         nvs_get_str(handle_, key, nullptr, &len) == ESP_OK ||
+         nvs_get_u8(handle_, key, &u8) == ESP_OK;
+#endif
+}
+
+bool Store::remove(const char* key) {
+  CRG_STAT(writes);
+  if (!open_ || nvs_erase_key(handle_, key) != ESP_OK) return false;
+  dirty_ = true;
+  return true;
+}
+
+bool Store::clear() {
+  CRG_STAT(writes);
+  if (!open_ || nvs_erase_all(handle_) != ESP_OK) return false;
+  dirty_ = true;
+  return true;
+}
+
+#endif // CRG_STORAGE_BACKEND
+
+#undef CRG_STAT
+
+} // namespace crg
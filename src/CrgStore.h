@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nvs.h"
+
+#include "CrgConfig.h"
+
+#define CRG_STORAGE_NVS      0 // NVS (общий раздел nvs)
+#define CRG_STORAGE_FLASHLOG 1 // журнал на отдельном data-разделе (CrgFlashLog.h)
+
+#ifndef CRG_STORAGE_BACKEND
+  #define CRG_STORAGE_BACKEND CRG_STORAGE_NVS
+#endif
+
+#ifndef CRG_FEATURE_STORE_STATS
+  // 0 — не считать операции с хранилищем (storeStats() вернёт нули).
+  #define CRG_FEATURE_STORE_STATS 1
+#endif
+
+namespace crg {
+
+// Счётчики операций с хранилищем (общие для всех экземпляров гварда).
+struct StoreStats {
+  uint32_t opens   = 0; // открытые сессии namespace
+  uint32_t reads   = 0; // get*/isKey
+  uint32_t writes  = 0; // put*/remove
+  uint32_t commits = 0; // nvs_commit() / запись в журнал
+};
+
+const StoreStats& storeStats();
+void resetStoreStats();
+
+// Единая точка доступа гварда к persistent-хранилищу. API как у Preferences,
+// но поверх nvs_handle_t или журнала CRG_STORAGE_FLASHLOG: put*/remove только
+// пишут, фиксация — одна на сессию (commit() или end()). Перед esp_restart()
+// нужен явный commit().
+class Store {
+public:
+  Store() = default;
+  ~Store() { end(); }
+  Store(const Store&) = delete;
+  Store& operator=(const Store&) = delete;
+
+  bool begin(const char* ns, bool readOnly);
+  void end();
+  bool commit();
+
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+  size_t   putUInt(const char* key, uint32_t value);
+  uint8_t  getUChar(const char* key, uint8_t defaultValue = 0);
+  size_t   putUChar(const char* key, uint8_t value);
+  size_t   getString(const char* key, char* out, size_t len);
+  size_t   putString(const char* key, const char* value);
+  size_t   getBytes(const char* key, void* out, size_t len);
+  size_t   putBytes(const char* key, const void* value, size_t len);
+  bool     isKey(const char* key);
+  bool     remove(const char* key);
+  bool     clear(); // все ключи namespace
+
+private:
+#if CRG_STORAGE_BACKEND == CRG_STORAGE_FLASHLOG
+  const uint8_t* find_(const char* key, size_t* len);
+  bool set_(const char* key, const void* value, size_t len);
+
+  char ns_[NVS_KEY_NAME_MAX_SIZE] = {0};
+  bool readOnly_ = false;
+#else
+  nvs_handle_t handle_ = 0;
+#endif
+  bool open_ = false;
+  bool dirty_ = false;
+};
+
+} // namespace crg